@@ -0,0 +1,287 @@
+/**
+ * @file pn532_bench.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Host benchmarks for the codec, checksum, hex and scan decoding hot paths
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532.h"
+#include "pn532_mfc.h"
+#include "pn532_sim.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Reaches the private helpers of PN532, see the friend declaration there
+class PN532_Benchmark {
+public:
+    static uint8_t dcs(PN532 &nfc, uint8_t *data, size_t length) { return nfc.dcs(data, length); }
+    static void appendCrcA(PN532 &nfc, std::vector<uint8_t> &data) { nfc.appendCrcA(data); }
+    static void appendCrc16Ccitt(PN532 &nfc, std::vector<uint8_t> &data) { nfc.appendCrc16Ccitt(data); }
+    static String bytes2HexString(PN532 &nfc, std::vector<uint8_t> &data)
+    {
+        return nfc.bytes2HexString(&data, data.size());
+    }
+    static std::vector<uint8_t> hexStringToUint8Array(PN532 &nfc, const std::string &hex)
+    {
+        return nfc.hexStringToUint8Array(hex);
+    }
+    static PN532::Iso14aTagInfo parseHf14aScan(PN532 &nfc, std::vector<uint8_t> &data)
+    {
+        return nfc.parseHf14aScan(data.data(), data.size());
+    }
+    static PN532::Iso15TagInfo parseHf15Scan(PN532 &nfc, std::vector<uint8_t> &data)
+    {
+        return nfc.parseHf15Scan(data.data(), data.size());
+    }
+    static PN532::LfTagInfo parseLfScan(PN532 &nfc, std::vector<uint8_t> &data)
+    {
+        return nfc.parseLfScan(data.data(), data.size());
+    }
+};
+
+namespace
+{
+    // Hands notifications straight to the engine, nothing is ever written
+    class LoopbackTransport : public PN532_Transport {
+    public:
+        bool isConnected() override { return true; }
+        bool write(const uint8_t *, size_t) override { return true; }
+        void notify(const uint8_t *data, size_t length) { receive(data, length); }
+    };
+
+    template <typename T> void keep(const T &value) { asm volatile("" : : "g"(&value) : "memory"); }
+
+    struct Options {
+        double minTimeMs = 200;
+        const char *filter = nullptr;
+    };
+
+    Options options;
+    bool firstResult = true;
+
+    // Runs fn in growing batches until minTimeMs passed, prints one JSON object
+    template <typename Fn> void run(const char *name, size_t bytes, Fn fn, double minTimeMs = 0)
+    {
+        if (options.filter && !strstr(name, options.filter))
+        {
+            return;
+        }
+        minTimeMs = minTimeMs > 0 ? minTimeMs : options.minTimeMs;
+
+        fn(); // warm up
+        uint64_t iterations = 0;
+        uint64_t batch = 1;
+        auto start = std::chrono::steady_clock::now();
+        double elapsedMs = 0;
+        while (elapsedMs < minTimeMs)
+        {
+            for (uint64_t i = 0; i < batch; i++)
+            {
+                fn();
+            }
+            iterations += batch;
+            batch *= 2;
+            elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        double nsPerOp = elapsedMs * 1e6 / iterations;
+        double mbPerSecond = bytes > 0 ? bytes * 1e3 / nsPerOp : 0;
+        printf(
+            "%s\n  {\"name\": \"%s\", \"bytes\": %zu, \"iterations\": %llu, \"ns_per_op\": %.1f, \"mb_per_s\": %.2f}",
+            firstResult ? "" : ",", name, bytes, (unsigned long long)iterations, nsPerOp, mbPerSecond);
+        fflush(stdout);
+        firstResult = false;
+    }
+
+    std::vector<uint8_t> payload(size_t length)
+    {
+        std::vector<uint8_t> data(length);
+        for (size_t i = 0; i < length; i++)
+        {
+            data[i] = i * 37 + 11;
+        }
+        return data;
+    }
+
+    // Frame sizes seen in practice: short commands, a Classic block, an
+    // Ultralight read, a long APDU and the largest normal and extended frames
+    const size_t SIZES[] = {2, 16, 64, 253, 263};
+
+    void benchCodec()
+    {
+        char name[64];
+        for (size_t size : SIZES)
+        {
+            std::vector<uint8_t> data = payload(size);
+            uint8_t frame[PN532_FrameEncoder::MAX_FRAME_SIZE];
+
+            snprintf(name, sizeof(name), "encode/%zu", size);
+            run(name, size,
+                [&]()
+                {
+                    size_t length = PN532_FrameEncoder::encode(frame, sizeof(frame), 0xD4, 0x40, data.data(), size);
+                    keep(length);
+                    keep(frame);
+                });
+
+            // ACK and reply as a bridge sends them, in 20 byte notifications
+            std::vector<uint8_t> wire = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+            size_t length = PN532_FrameEncoder::encode(frame, sizeof(frame), 0xD5, 0x41, data.data(), size);
+            wire.insert(wire.end(), frame, frame + length);
+
+            snprintf(name, sizeof(name), "parse/%zu", size);
+            PN532_FrameParser parser;
+            run(name, wire.size(),
+                [&]()
+                {
+                    int frames = 0;
+                    for (uint8_t b : wire)
+                    {
+                        frames += parser.feed(b) == PN532_FrameParser::EventFrame;
+                    }
+                    keep(frames);
+                });
+
+            // Transport callback to committed response, the path NotifyCallBack runs
+            snprintf(name, sizeof(name), "receive/%zu", size);
+            LoopbackTransport transport;
+            PN532 nfc(&transport);
+            run(name, wire.size(),
+                [&]()
+                {
+                    for (size_t offset = 0; offset < wire.size(); offset += 20)
+                    {
+                        transport.notify(wire.data() + offset, std::min<size_t>(20, wire.size() - offset));
+                    }
+                    nfc.pn532Responses.pop();
+                });
+        }
+    }
+
+    void benchChecksums()
+    {
+        char name[64];
+        PN532 nfc;
+        for (size_t size : SIZES)
+        {
+            std::vector<uint8_t> data = payload(size);
+            data.reserve(size + 2);
+
+            snprintf(name, sizeof(name), "dcs/%zu", size);
+            run(name, size, [&]() { keep(PN532_Benchmark::dcs(nfc, data.data(), size)); });
+
+            snprintf(name, sizeof(name), "crc_a/%zu", size);
+            run(name, size,
+                [&]()
+                {
+                    PN532_Benchmark::appendCrcA(nfc, data);
+                    keep(data[size]);
+                    data.resize(size);
+                });
+
+            snprintf(name, sizeof(name), "crc16_ccitt/%zu", size);
+            run(name, size,
+                [&]()
+                {
+                    PN532_Benchmark::appendCrc16Ccitt(nfc, data);
+                    keep(data[size]);
+                    data.resize(size);
+                });
+        }
+    }
+
+    void benchHex()
+    {
+        char name[64];
+        PN532 nfc;
+        // UIDs, a block, a page dump
+        const size_t sizes[] = {4, 7, 8, 16, 64};
+        for (size_t size : sizes)
+        {
+            std::vector<uint8_t> data = payload(size);
+            std::string hex(PN532_Benchmark::bytes2HexString(nfc, data).c_str());
+
+            snprintf(name, sizeof(name), "bytes2hex/%zu", size);
+            run(name, size, [&]() { keep(PN532_Benchmark::bytes2HexString(nfc, data)); });
+
+            snprintf(name, sizeof(name), "hex2bytes/%zu", size);
+            run(name, size, [&]() { keep(PN532_Benchmark::hexStringToUint8Array(nfc, hex)); });
+        }
+    }
+
+    void benchDecoders()
+    {
+        PN532 nfc;
+        // NbTg, Tg, ATQA, SAK, UID length, UID: a 7 byte UID NTAG
+        std::vector<uint8_t> hf14a = {0x01, 0x01, 0x00, 0x44, 0x00, 0x07, 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+        // Type, Tg, UID LSB first
+        std::vector<uint8_t> hf15 = {0x01, 0x01, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0xE0};
+        std::vector<uint8_t> lf = {0x01, 0x01, 0x12, 0x34, 0x56, 0x78, 0x9A};
+
+        run("decode/hf14a_scan", hf14a.size(), [&]() { keep(PN532_Benchmark::parseHf14aScan(nfc, hf14a)); });
+        run("decode/hf15_scan", hf15.size(), [&]() { keep(PN532_Benchmark::parseHf15Scan(nfc, hf15)); });
+        run("decode/lf_scan", lf.size(), [&]() { keep(PN532_Benchmark::parseLfScan(nfc, lf)); });
+    }
+
+    // Whole operations against the simulator with a BLE-like latency per
+    // reply, so they show round trips rather than CPU time
+    void benchEndToEnd()
+    {
+        PN532_Simulator::Config config;
+        config.latencyUs = 2000;
+        config.fragmentGapUs = 100;
+        config.mtu = 23;
+
+        PN532_Simulator sim(config);
+        sim.setIso14aCard(PN532_Simulator::mifareClassic1K({0xDE, 0xAD, 0xBE, 0xEF}));
+        sim.setIso15Card(PN532_Simulator::iso15693({0xE0, 0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06}));
+        PN532 nfc(&sim);
+        PN532_MifareClassic mfc(nfc);
+
+        run("e2e/mfc_1k_dump", 1024,
+            [&]()
+            {
+                nfc.hf14aTagInfo = PN532::Iso14aTagInfo();
+                PN532_MifareClassic::Dump dump;
+                mfc.dump(dump);
+                keep(dump.blocksRead);
+            },
+            2000);
+
+        run("e2e/hf15_inventory", 0, [&]() { keep(nfc.hf15Scan()); }, 1000);
+        run("e2e/hf14a_scan", 0, [&]() { keep(nfc.hf14aScan()); }, 1000);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+        {
+            options.minTimeMs = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--min-time ms] [--filter substring]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("[");
+    benchCodec();
+    benchChecksums();
+    benchHex();
+    benchDecoders();
+    benchEndToEnd();
+    printf("\n]\n");
+    return 0;
+}
@@ -0,0 +1,1480 @@
+/**
+ * @file pn532.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief PN532 protocol engine and command layer
+ * @version 0.0.1
+ * @date 2024-11-06
+ */
+
+#include "pn532.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // Anticollision reply: status, four UID bytes and their BCC
+    bool uidPartValid(const std::vector<uint8_t> &reply)
+    {
+        return reply.size() >= 6 && reply[0] == 0x00 && (reply[1] ^ reply[2] ^ reply[3] ^ reply[4]) == reply[5];
+    }
+
+    // PN532 error code in the low bits of the InCommunicateThru status
+    const uint8_t STATUS_TIMEOUT = 0x01;
+    const uint8_t STATUS_COLLISION = 0x06;
+    // Inventory round trips before hf15Inventory gives up on splitting
+    const uint16_t HF15_INVENTORY_MAX_SLOTS = 256;
+}
+
+PN532::PN532(PN532_Transport *transport, bool debug)
+{
+    _debug = debug;
+    setTransport(transport);
+}
+
+PN532::~PN532()
+{
+    if (_transport)
+    {
+        _transport->setReceiveCallback(nullptr);
+        _transport->setLinkLostCallback(nullptr);
+    }
+}
+
+void PN532::setTransport(PN532_Transport *transport)
+{
+    if (_transport && _transport != transport)
+    {
+        _transport->setReceiveCallback(nullptr);
+        _transport->setLinkLostCallback(nullptr);
+    }
+    _transport = transport;
+    _registers.invalidate();
+    if (_transport)
+    {
+        _transport->setReceiveCallback([this](const uint8_t *pData, size_t length) { this->onReceive(pData, length); });
+        _transport->setLinkLostCallback([this]() { this->wake(); });
+    }
+}
+
+void PN532::onReceive(const uint8_t *pData, size_t length)
+{
+    #if PN532_TRACE
+    trace.recordRx(pData, length);
+    #endif
+    if (_debug)
+    {
+        PN532_LOG_FRAME("PN532 ->", pData, length);
+    }
+    metrics.recordNotification(length);
+    if (_rxReset.exchange(false))
+    {
+        _parser.reset();
+        _rxFragments = 0;
+        _rxBytes = 0;
+    }
+    if (_rxFragments == 0)
+    {
+        _rxFirstUs = micros();
+    }
+    _rxFragments++;
+    _rxBytes += length;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        switch (_parser.feed(pData[i]))
+        {
+        case PN532_FrameParser::EventFrame:
+            handleFrame(_parser.frame(), _parser.frameLength(), false);
+            break;
+        case PN532_FrameParser::EventError:
+            handleFrame(_parser.frame(), _parser.frameLength(), true);
+            break;
+        case PN532_FrameParser::EventChecksumError:
+            metrics.recordChecksumError();
+            PN532_LOGW("Invalid frame checksum");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void PN532::handleFrame(const uint8_t *frame, size_t length, bool isError)
+{
+    if (!isError && (length < 2 || frame[0] != DATA_TIF_RECEIVE))
+    {
+        return;
+    }
+
+    // Built in place in the ring slot, the consumer only sees it after commit
+    PN532::CmdResponse *rsp = pn532Responses.acquire();
+    if (!rsp)
+    {
+        metrics.recordDroppedResponse();
+        _rxFragments = 0;
+        _rxBytes = 0;
+        return;
+    }
+    memcpy(rsp->raw, frame, length);
+    rsp->length = length;
+    rsp->firstNotifyUs = _rxFirstUs;
+    rsp->receivedUs = micros();
+    rsp->fragments = _rxFragments;
+    rsp->wireBytes = _rxBytes;
+    _rxFragments = 0;
+    _rxBytes = 0;
+
+    if (isError)
+    {
+        // No command code, dispatchResponse gives it the oldest one in flight
+        rsp->command = 0;
+        rsp->status = FRAME_ERROR;
+        rsp->dataSize = 0;
+    }
+    else
+    {
+        rsp->command = frame[1] - 1;
+        rsp->status = HF_TAG_OK;
+        rsp->dataSize = length - 2;
+        memcpy(rsp->data, frame + 2, rsp->dataSize);
+    }
+    pn532Responses.commit();
+    wake();
+}
+
+void PN532::wake()
+{
+    _responseSignal.notify();
+    if (_wakeSignal)
+    {
+        _wakeSignal->notify();
+    }
+}
+
+bool PN532::writeCommand(Command cmd, const uint8_t *data, size_t length)
+{
+    return execute(cmd, data, length, false);
+}
+
+bool PN532::writeFrame(const uint8_t *frame, size_t length)
+{
+    return execute((Command)frame[6], frame, length, true);
+}
+
+bool PN532::execute(Command cmd, const uint8_t *data, size_t length, bool prebuilt)
+{
+    if (_callbackDepth > 0)
+    {
+        PN532_LOGE("Blocking command issued from a completion callback");
+        return false;
+    }
+
+    bool done = false;
+    bool success = false;
+    CommandCallback callback = [this, &done, &success](bool ok, const CmdResponse &response)
+    {
+        done = true;
+        success = ok;
+        copyResponse(response, cmdResponse);
+    };
+
+    uint32_t timeoutMs = getCommandTimeout(cmd);
+    while (!enqueue(cmd, data, length, prebuilt, callback, timeoutMs))
+    {
+        // Only a full queue is worth waiting for, pending register writes need a second slot
+        if (!_transport || _requests.size() + (_registers.hasPending() ? 2 : 1) <= _requests.capacity())
+        {
+            return false;
+        }
+        process(timeoutMs);
+    }
+    while (!done)
+    {
+        process(timeoutMs);
+    }
+    return success;
+}
+
+bool PN532::writeCommand(Command cmd, const std::vector<uint8_t> &data)
+{
+    return writeCommand(cmd, data.data(), data.size());
+}
+
+bool PN532::writeCommand(Command cmd, std::initializer_list<uint8_t> data)
+{
+    return writeCommand(cmd, data.begin(), data.size());
+}
+
+void PN532::copyResponse(const CmdResponse &from, CmdResponse &to)
+{
+    // Only the bytes in use, not the whole extended frame sized buffers
+    to.length = from.length;
+    to.command = from.command;
+    to.status = from.status;
+    to.dataSize = from.dataSize;
+    to.firstNotifyUs = from.firstNotifyUs;
+    to.receivedUs = from.receivedUs;
+    to.fragments = from.fragments;
+    to.wireBytes = from.wireBytes;
+    memcpy(to.raw, from.raw, from.length);
+    memcpy(to.data, from.data, from.dataSize);
+}
+
+size_t PN532::readResponse(uint8_t *out, size_t capacity)
+{
+    if (cmdResponse.dataSize == 0 || cmdResponse.dataSize > capacity)
+    {
+        return 0;
+    }
+    memcpy(out, cmdResponse.data, cmdResponse.dataSize);
+    return cmdResponse.dataSize;
+}
+
+void PN532::setCommandTimeout(Command cmd, uint32_t timeoutMs)
+{
+    _commandTimeouts[cmd] = std::min<uint32_t>(timeoutMs, 0xFFFF);
+}
+
+uint32_t PN532::getCommandTimeout(Command cmd)
+{
+    if (_commandTimeouts[cmd] != 0)
+    {
+        return _commandTimeouts[cmd];
+    }
+
+    switch (cmd)
+    {
+    case InListPassiveTarget:
+    case InAutoPoll:
+    case TgInitAsTarget:
+    case TgGetData:
+        // Waits for a card or an initiator to show up
+        return 4000;
+    case InDataExchange:
+    case InCommunicateThru:
+    case TgSetData:
+        return 1000;
+    default:
+        return 500;
+    }
+}
+
+void PN532::setPipelineDepth(uint8_t depth) { _pipelineDepth = std::max<uint8_t>(depth, 1); }
+
+bool PN532::submit(Command cmd, const uint8_t *data, size_t length, CommandCallback callback, uint32_t timeoutMs)
+{
+    if (cmd == WriteRegister)
+    {
+        forgetRegisters(data, length);
+    }
+    return enqueue(cmd, data, length, false, callback, timeoutMs);
+}
+
+bool PN532::submitFrame(const uint8_t *frame, size_t length, CommandCallback callback, uint32_t timeoutMs)
+{
+    // 00 00 FF LEN LCS TFI CMD ..., extended frames have FF FF LENM LENL LCS before TFI
+    bool extended = length > 4 && frame[3] == 0xFF && frame[4] == 0xFF;
+    if (length < (extended ? 12u : 9u))
+    {
+        PN532_LOGE("Frame too short");
+        return false;
+    }
+    Command cmd = (Command)frame[extended ? 9 : 6];
+    if (cmd == WriteRegister)
+    {
+        forgetRegisters(frame + (extended ? 10 : 7), length - (extended ? 12 : 9));
+    }
+    return enqueue(cmd, frame, length, true, callback, timeoutMs);
+}
+
+bool PN532::enqueue(
+    Command cmd, const uint8_t *data, size_t length, bool prebuilt, CommandCallback callback, uint32_t timeoutMs)
+{
+    if (!_transport)
+    {
+        return false;
+    }
+
+    if (_registers.hasPending())
+    {
+        // Pending register writes go first, and only together with this request
+        if (_requests.size() + 2 > _requests.capacity() || !flushRegisters())
+        {
+            return false;
+        }
+    }
+
+    // Commands that reach a target let the firmware set up the CIU, e.g.
+    // InListPassiveTarget turns the CRC back on
+    if (cmd != WriteRegister && cmd != ReadRegister && cmd != InCommunicateThru && cmd != GetFirmwareVersion)
+    {
+        _registers.invalidate();
+    }
+
+    AsyncRequest *request = _requests.acquire();
+    if (!request)
+    {
+        return false;
+    }
+    if (prebuilt)
+    {
+        request->wire = data;
+        request->frameLength = length;
+    }
+    else
+    {
+        request->wire = request->frame;
+        request->frameLength =
+            PN532_FrameEncoder::encode(request->frame, sizeof(request->frame), DATA_TIF_SEND, cmd, data, length);
+        if (request->frameLength == 0)
+        {
+            PN532_LOGE("Command payload too long");
+            return false;
+        }
+    }
+    request->command = cmd;
+    request->cancelled = false;
+    request->notSent = false;
+    request->timeoutMs = timeoutMs != 0 ? timeoutMs : getCommandTimeout(cmd);
+    request->callback = callback;
+    _requests.commit();
+
+    sendQueued();
+    return true;
+}
+
+bool PN532::submit(Command cmd, const std::vector<uint8_t> &data, CommandCallback callback, uint32_t timeoutMs)
+{
+    return submit(cmd, data.data(), data.size(), callback, timeoutMs);
+}
+
+bool PN532::submit(Command cmd, std::initializer_list<uint8_t> data, CommandCallback callback, uint32_t timeoutMs)
+{
+    return submit(cmd, data.begin(), data.size(), callback, timeoutMs);
+}
+
+size_t PN532::process(uint32_t waitMs)
+{
+    if (!_transport)
+    {
+        return _requests.size();
+    }
+    unsigned long startTime = millis();
+    while (true)
+    {
+        if (_inFlight > 0 && _transport->linkLost())
+        {
+            recoverLink();
+        }
+        sendQueued();
+
+        bool completed = false;
+        PN532::CmdResponse *rsp;
+        while ((rsp = pn532Responses.front()) != nullptr)
+        {
+            completed |= dispatchResponse(rsp);
+        }
+        completed |= expireRequests();
+
+        if (completed || _requests.empty())
+        {
+            return _requests.size();
+        }
+
+        unsigned long elapsed = millis() - startTime;
+        if (elapsed >= waitMs)
+        {
+            return _requests.size();
+        }
+
+        // Sleep until a response is committed, but not past the oldest deadline
+        uint32_t waitFor = waitMs - elapsed;
+        AsyncRequest *oldest = _requests.front();
+        if (_inFlight > 0)
+        {
+            unsigned long age = millis() - oldest->sentAt;
+            waitFor = std::min<uint32_t>(waitFor, age < oldest->timeoutMs ? oldest->timeoutMs - age : 0);
+        }
+        _responseSignal.wait(waitFor);
+    }
+}
+
+bool PN532::flush(uint32_t timeoutMs)
+{
+    unsigned long startTime = millis();
+    while (!_requests.empty())
+    {
+        unsigned long elapsed = millis() - startTime;
+        if (elapsed >= timeoutMs)
+        {
+            return false;
+        }
+        process(timeoutMs - elapsed);
+    }
+    return true;
+}
+
+size_t PN532::cancel()
+{
+    size_t cancelled = 0;
+    // Callbacks may queue new requests, those are not ours to drop
+    size_t end = _requests.size();
+    for (size_t i = _inFlight; i < end; i++)
+    {
+        AsyncRequest *request = _requests.peek(i);
+        if (request->cancelled)
+        {
+            continue;
+        }
+        request->cancelled = true;
+        cancelled++;
+
+        CommandCallback callback = std::move(request->callback);
+        request->callback = nullptr;
+        if (callback)
+        {
+            _noResponse.command = request->command;
+            _noResponse.status = NO_RESPONSE;
+            _noResponse.length = 0;
+            _noResponse.dataSize = 0;
+            _callbackDepth++;
+            callback(false, _noResponse);
+            _callbackDepth--;
+        }
+    }
+    sendQueued();
+    return cancelled;
+}
+
+void PN532::sendQueued()
+{
+    AsyncRequest *request;
+    while (_inFlight < _pipelineDepth && (request = _requests.peek(_inFlight)) != nullptr)
+    {
+        if (request->cancelled)
+        {
+            // Cancelled slots can only leave the ring from the front
+            if (_inFlight > 0)
+            {
+                break;
+            }
+            _requests.pop();
+            continue;
+        }
+
+    #if PN532_TRACE
+        trace.recordTx(request->wire, request->frameLength);
+    #endif
+        if (_debug)
+        {
+            PN532_LOG_FRAME("PN532 <-", request->wire, request->frameLength);
+        }
+
+        request->sentAt = millis();
+        request->sentAtUs = micros();
+        metrics.recordRequest(request->command, request->frameLength);
+        _inFlight++;
+        if (!_transport->write(request->wire, request->frameLength))
+        {
+            // Let expireRequests fail it right away
+            request->timeoutMs = 0;
+            request->notSent = true;
+        }
+    }
+}
+
+void PN532::recoverLink()
+{
+    // The parser belongs to the receive path, have it start over there
+    _rxReset = true;
+    if (!_transport->restoreLink())
+    {
+        // Nothing will answer, let expireRequests fail them right away
+        for (size_t i = 0; i < _inFlight; i++)
+        {
+            _requests.peek(i)->timeoutMs = 0;
+            _requests.peek(i)->notSent = true;
+        }
+        return;
+    }
+    // The replies were lost with the link, sendQueued sends the frames again
+    _inFlight = 0;
+}
+
+bool PN532::dispatchResponse(PN532::CmdResponse *rsp)
+{
+    // The reader answers in order, so the reply belongs to the oldest
+    // in-flight request with the same command code; an error frame has none
+    // and answers the oldest one
+    if (rsp->status == FRAME_ERROR && _inFlight > 0)
+    {
+        rsp->command = _requests.front()->command;
+    }
+    size_t match = 0;
+    while (match < _inFlight && _requests.peek(match)->command != rsp->command)
+    {
+        match++;
+    }
+    if (match == _inFlight)
+    {
+        metrics.recordUnmatched();
+        if (_debug)
+        {
+            PN532_LOGD("Dropping unmatched response.");
+        }
+        pn532Responses.pop();
+        return false;
+    }
+
+    if (_debug)
+    {
+        PN532_LOG_FRAME("PN532 Response:", rsp->raw, rsp->length);
+        PN532_LOGD("Response Command: %X", rsp->command);
+        PN532_LOGD("    Status: %X", rsp->status);
+        PN532_LOGD("    Size: %u", rsp->dataSize);
+        PN532_LOG_FRAME("    Data:", rsp->data, rsp->dataSize);
+    }
+
+    // Requests sent before the matched one will never see their reply
+    for (size_t i = 0; i < match; i++)
+    {
+        metrics.recordLost(_requests.front()->command);
+        completeRequest(false, nullptr);
+    }
+    AsyncRequest *request = _requests.front();
+    // With more than one frame on the air the first notification may predate this request
+    long firstNotifyUs = (long)(rsp->firstNotifyUs - request->sentAtUs);
+    metrics.recordResponse(
+        rsp->command, rsp->status == FRAME_ERROR, firstNotifyUs > 0 ? firstNotifyUs : 0,
+        rsp->receivedUs - request->sentAtUs, rsp->fragments, rsp->wireBytes);
+    // The callback reads the ring slot in place, it is only released afterwards
+    completeRequest(rsp->status != FRAME_ERROR, rsp);
+    pn532Responses.pop();
+    return true;
+}
+
+bool PN532::expireRequests()
+{
+    bool expired = false;
+    while (_inFlight > 0)
+    {
+        AsyncRequest *request = _requests.front();
+        if (millis() - request->sentAt < request->timeoutMs)
+        {
+            break;
+        }
+        if (request->notSent)
+        {
+            PN532_LOGW("Command %02X was not sent", request->command);
+            _noResponse.command = request->command;
+            _noResponse.status = NOT_SENT;
+            _noResponse.length = 0;
+            _noResponse.dataSize = 0;
+            completeRequest(false, &_noResponse);
+            expired = true;
+            continue;
+        }
+        metrics.recordTimeout(request->command);
+        PN532_LOGW("Timeout waiting for response to command %02X", request->command);
+        completeRequest(false, nullptr);
+        expired = true;
+    }
+    return expired;
+}
+
+void PN532::completeRequest(bool success, const CmdResponse *response)
+{
+    AsyncRequest *request = _requests.front();
+    CommandCallback callback = std::move(request->callback);
+    request->callback = nullptr;
+    if (!response)
+    {
+        _noResponse.command = request->command;
+        _noResponse.status = NO_RESPONSE;
+        _noResponse.length = 0;
+        _noResponse.dataSize = 0;
+        response = &_noResponse;
+    }
+    _requests.pop();
+    _inFlight--;
+
+    // Get the next frame on the air before running the callback
+    sendQueued();
+
+    if (callback)
+    {
+        _callbackDepth++;
+        callback(success, *response);
+        _callbackDepth--;
+    }
+}
+
+void PN532::writeData(const std::vector<uint8_t> &data)
+{
+    if (_transport)
+    {
+        _transport->write(data.data(), data.size());
+    }
+}
+
+String PN532::getTagType()
+{
+    switch (hf14aTagInfo.sak)
+    {
+    case 0x09:
+        return "MIFARE Mini";
+    case 0x08:
+    case 0x88:
+        return "MIFARE 1K";
+    case 0x18:
+        return "MIFARE 4K";
+    case 0x00:
+        return "MIFARE Ultralight";
+    default:
+        return "Unknown";
+    }
+}
+
+String PN532::getHf14aTagType()
+{
+    switch (hf14aTagInfo.sak)
+    {
+    case 0x09:
+        return "MIFARE Mini";
+    case 0x08:
+    case 0x88:
+        return "MIFARE 1K";
+    case 0x18:
+        return "MIFARE 4K";
+    case 0x00:
+        return "MIFARE Ultralight";
+    default:
+        return "Unknown";
+    }
+}
+
+String PN532::getHf15TagType() { return "ISO15693"; }
+void PN532::wakeup()
+{
+    // Leaving power down may reset the CIU
+    _registers.invalidate();
+    writeData(
+        {0x55, 0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+}
+
+bool PN532::setNormalMode()
+{
+    wakeup();
+    return writeCommand<NormalModeFrame>();
+}
+
+bool PN532::getVersion() { return writeCommand<GetFirmwareVersionFrame>(); }
+PN532::Iso14aTagInfo PN532::hf14aScan()
+{
+    bool res = writeCommand<ListIso14aFrame>();
+    if (!res)
+    {
+        return PN532::Iso14aTagInfo();
+    }
+    u_int8_t *data = cmdResponse.data;
+    size_t dataSize = cmdResponse.dataSize;
+    return parseHf14aScan(data, dataSize);
+}
+
+PN532::Iso14aTagInfo PN532::parseHf14aScan(uint8_t *data, size_t dataSize)
+{
+    // NbTg, Tg, ATQA, SAK, UID length, UID
+    if (dataSize < 6 || data[0] == 0 || dataSize < 6 + (size_t)data[5])
+    {
+        hf14aTagInfo = PN532::Iso14aTagInfo();
+        return hf14aTagInfo;
+    }
+    hf14aTagInfo.atqa = {data[2], data[3]};
+    hf14aTagInfo.sak = data[4];
+    hf14aTagInfo.uidSize = data[5];
+    hf14aTagInfo.uid.assign(data + 6, data + 6 + hf14aTagInfo.uidSize);
+    hf14aTagInfo.uid_hex = "";
+    for (size_t i = 0; i < hf14aTagInfo.uid.size(); i++)
+    {
+        hf14aTagInfo.uid_hex += hf14aTagInfo.uid[i] < 0x10 ? "0" : "";
+        hf14aTagInfo.uid_hex += String(hf14aTagInfo.uid[i], HEX);
+    }
+    hf14aTagInfo.uid_hex.toUpperCase();
+    hf14aTagInfo.atqa_hex = bytes2HexString(&hf14aTagInfo.atqa, 2);
+    std::vector<uint8_t> sakVector = {hf14aTagInfo.sak};
+    hf14aTagInfo.sak_hex = bytes2HexString(&sakVector, 1);
+    hf14aTagInfo.type = getTagType();
+    return hf14aTagInfo;
+}
+
+size_t PN532::hf14aInventory(PN532_TagList<Iso14aTarget> &out)
+{
+    out.clear();
+    if (!writeCommand<ListIso14aAllFrame>())
+    {
+        return 0;
+    }
+    return parseHf14aTargets(cmdResponse.data, cmdResponse.dataSize, out);
+}
+
+size_t PN532::parseHf14aTargets(const uint8_t *data, size_t dataSize, PN532_TagList<Iso14aTarget> &out)
+{
+    if (dataSize < 1)
+    {
+        return out.size();
+    }
+    size_t offset = 1;
+    for (uint8_t i = 0; i < data[0]; i++)
+    {
+        if (offset + 5 > dataSize || data[offset + 4] > 10 || offset + 5 + data[offset + 4] > dataSize)
+        {
+            break;
+        }
+        Iso14aTarget target;
+        target.atqa[0] = data[offset + 1];
+        target.atqa[1] = data[offset + 2];
+        target.sak = data[offset + 3];
+        target.uidSize = data[offset + 4];
+        memcpy(target.uid, data + offset + 5, target.uidSize);
+        offset += 5 + target.uidSize;
+        // ISO14443-4 compliant, the ATS follows with its length first
+        if ((target.sak & 0x20) && offset < dataSize)
+        {
+            offset += std::max<uint8_t>(data[offset], 1);
+        }
+        out.add(target);
+    }
+    return out.size();
+}
+
+bool PN532::mfAuth(std::vector<uint8_t> uid, uint8_t block, uint8_t *key, bool useKeyA)
+{
+    std::vector<uint8_t> authData = {0x01};
+    authData.push_back(useKeyA ? 0x60 : 0x61);
+    authData.push_back(block);
+    authData.insert(authData.end(), key, key + 6);
+    uint8_t uidLength = uid.size();
+    authData.insert(authData.end(), uid.end() - 4, uid.end());
+    bool res = writeCommand(InDataExchange, authData);
+    if (!res)
+    {
+        return false;
+    }
+    return cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
+}
+
+std::vector<uint8_t> PN532::mfRdbl(uint8_t block)
+{
+    std::vector<uint8_t> readBlockCommands = {0x01, 0x30, block};
+    bool res = writeCommand(InDataExchange, readBlockCommands);
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::mfRdbl(uint8_t block, uint8_t *out, size_t capacity)
+{
+    writeCommand(InDataExchange, {0x01, 0x30, block});
+    return readResponse(out, capacity);
+}
+
+bool PN532::mfWrbl(uint8_t block, std::vector<uint8_t> data)
+{
+    std::vector<uint8_t> writeBlockCommands = {0x01, 0xA0, block};
+    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
+    bool res = writeCommand(InDataExchange, writeBlockCommands);
+    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
+}
+
+bool PN532::mfuWrbl(uint8_t block, std::vector<uint8_t> data)
+{
+    std::vector<uint8_t> writeBlockCommands = {0x01, 0xA2, block};
+    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
+    bool res = writeCommand(InDataExchange, writeBlockCommands);
+    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
+}
+
+std::vector<uint8_t> PN532::sendData(std::vector<uint8_t> data, bool append_crc)
+{
+    if (append_crc)
+    {
+        appendCrcA(data);
+    }
+
+    writeCommand(InCommunicateThru, data.data(), data.size());
+    if (append_crc)
+    {
+        checkCardCrc(false);
+    }
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::sendData(const uint8_t *data, size_t length, bool append_crc, uint8_t *out, size_t capacity)
+{
+    if (!append_crc)
+    {
+        writeCommand(InCommunicateThru, data, length);
+        return readResponse(out, capacity);
+    }
+
+    uint8_t frame[PN532_FrameEncoder::MAX_PAYLOAD];
+    if (length + 2 > sizeof(frame))
+    {
+        return 0;
+    }
+    memcpy(frame, data, length);
+    PN532_Crc::appendCrcA(frame, length);
+    writeCommand(InCommunicateThru, frame, length + 2);
+    checkCardCrc(false);
+    return readResponse(out, capacity);
+}
+
+std::vector<uint8_t> PN532::send7bit(std::vector<uint8_t> data)
+{
+    writeRegister(REG_BIT_FRAMING, 0x07);
+    std::vector<uint8_t> responseData = sendData(data, false);
+    writeRegister(REG_BIT_FRAMING, 0x00);
+    return responseData;
+}
+
+bool PN532::resetRegister()
+{
+    // No CRC generation or check, the library appends and verifies it
+    writeRegister(REG_TX_MODE, 0x00);
+    writeRegister(REG_RX_MODE, 0x00);
+    return true;
+}
+
+void PN532::writeRegister(uint16_t address, uint8_t value)
+{
+    if (!_registers.write(address, value) && !(flushRegisters() && _registers.write(address, value)))
+    {
+        PN532_LOGE("Register write %04X dropped, queue full", address);
+    }
+}
+
+bool PN532::flushRegisters()
+{
+    if (!_registers.hasPending())
+    {
+        return true;
+    }
+    if (!_transport || _requests.size() == _requests.capacity())
+    {
+        return false;
+    }
+    uint8_t payload[PN532_RegisterCache::CAPACITY * 3];
+    size_t length = _registers.takePending(payload);
+    // Reply or not, the registers are unknown if the write did not go through
+    return enqueue(
+        WriteRegister, payload, length, false,
+        [this](bool ok, const CmdResponse &)
+        {
+            if (!ok)
+            {
+                _registers.invalidate();
+            }
+        },
+        0);
+}
+
+void PN532::forgetRegisters(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i + 2 < length; i += 3)
+    {
+        _registers.invalidate((data[i] << 8) | data[i + 1]);
+    }
+}
+bool PN532::halt()
+{
+    resetRegister();
+    sendData({0x50, 0x00}, false);
+    return true;
+}
+
+bool PN532::isGen1A()
+{
+    halt();
+    std::vector<uint8_t> unlock1 = send7bit({0x40});
+    if (unlock1.size() == 2 && unlock1[1] == 0x0A)
+    {
+        PN532_LOGI("Unlock1 success");
+        std::vector<uint8_t> unlock2 = sendData({0x43}, false);
+        if (unlock2.size() == 2 && unlock2[1] == 0x0A)
+        {
+            PN532_LOGI("Unlock2 success");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PN532::selectTag()
+{
+    PN532::Iso14aTagInfo tag_info = hf14aScan();
+    halt();
+    if (tag_info.uid.empty())
+    {
+        PN532_LOGI("No tag found");
+        return false;
+    }
+    size_t uid_length = tag_info.uid.size();
+    if (_debug)
+    {
+        PN532_LOGD("Found UID: %s", tag_info.uid_hex.c_str());
+    }
+
+    std::vector<uint8_t> wupa_result = send7bit({0x52});
+    if (_debug)
+    {
+        PN532_LOGD("WUPA: %s", bytes2HexString(&wupa_result, wupa_result.size()).c_str());
+    }
+
+    auto anti_coll_result = sendData({0x93, 0x20}, false);
+    if (_debug)
+    {
+        PN532_LOGD(
+            "Anticollision CL1: %s", bytes2HexString(&anti_coll_result, anti_coll_result.size()).c_str());
+    }
+
+    if (!uidPartValid(anti_coll_result))
+    {
+        if (_debug)
+        {
+            PN532_LOGD("Anticollision failed");
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> anti_coll_data(anti_coll_result.begin() + 1, anti_coll_result.begin() + 6);
+    std::vector<uint8_t> select_data = {0x93, 0x70};
+    select_data.insert(select_data.end(), anti_coll_data.begin(), anti_coll_data.end());
+    auto select_result = sendData(select_data, true);
+    if (_debug)
+    {
+        PN532_LOGD("Select CL1: %s", bytes2HexString(&select_result, select_result.size()).c_str());
+    }
+
+    if (uid_length == 4)
+    {
+        // SAK and its CRC_A, sendData dropped it if the CRC did not match
+        return select_result.size() == 4 && select_result[0] == 0x00;
+    }
+    else if (uid_length == 7)
+    {
+        auto anti_coll2_result = sendData({0x95, 0x20}, false);
+        if (_debug)
+        {
+            PN532_LOGD(
+                "Anticollision CL2: %s", bytes2HexString(&anti_coll2_result, anti_coll2_result.size()).c_str());
+        }
+        if (!uidPartValid(anti_coll2_result))
+        {
+            if (_debug)
+            {
+                PN532_LOGD("Anticollision CL2 failed");
+            }
+            return false;
+        }
+        std::vector<uint8_t> anti_coll2_data(anti_coll2_result.begin() + 1, anti_coll2_result.begin() + 6);
+        std::vector<uint8_t> select2_data = {0x95, 0x70};
+        select2_data.insert(select2_data.end(), anti_coll2_data.begin(), anti_coll2_data.end());
+        auto select2_result = sendData(select2_data, true);
+        if (_debug)
+        {
+            PN532_LOGD("Select CL2: %s", bytes2HexString(&select2_result, select2_result.size()).c_str());
+        }
+        return select2_result.size() == 4 && select2_result[0] == 0x00;
+    }
+    return false;
+}
+
+bool PN532::isGen3()
+{
+    bool selected = selectTag();
+    if (!selected)
+    {
+        return false;
+    }
+    std::vector<uint8_t> result = sendData({0x30, 0x00}, true);
+    return result.size() >= 16;
+}
+
+bool PN532::isGen4(std::string pwd)
+{
+    bool selected = selectTag();
+    if (!selected)
+    {
+        return false;
+    }
+    std::vector<uint8_t> auth_data = {0xCF};
+    std::vector<uint8_t> pwd_bytes = hexStringToUint8Array(pwd);
+    auth_data.insert(auth_data.end(), pwd_bytes.begin(), pwd_bytes.end());
+    auth_data.push_back(0xC6);
+    std::vector<uint8_t> result = sendData(auth_data, true);
+    return result.size() >= 15;
+}
+
+PN532::Iso15TagInfo PN532::hf15Scan()
+{
+    bool res = writeCommand<ListIso15Frame>();
+    if (!res)
+    {
+        return PN532::Iso15TagInfo();
+    }
+    u_int8_t *data = cmdResponse.data;
+    size_t dataSize = cmdResponse.dataSize;
+    hf15TagInfo = parseHf15Scan(data, dataSize);
+    return hf15TagInfo;
+}
+
+PN532::Iso15TagInfo PN532::parseHf15Scan(uint8_t *data, size_t dataSize)
+{
+    // NbTg, Tg, UID LSB first; the first target only
+    Iso15TagInfo tagInfo;
+    if (dataSize < 10 || data[0] == 0)
+    {
+        return tagInfo;
+    }
+    tagInfo.uid.assign(data + 2, data + 10);
+    std::reverse(tagInfo.uid.begin(), tagInfo.uid.end());
+    tagInfo.uid_hex = bytes2HexString(&tagInfo.uid, 8);
+    return tagInfo;
+}
+
+size_t PN532::hf15Inventory(PN532_TagList<Iso15Target> &out)
+{
+    out.clear();
+    // Switches the reader to ISO15693; with several tags it may list none
+    writeCommand<ListIso15Frame>();
+
+    uint8_t mask[8] = {};
+    uint16_t slots = HF15_INVENTORY_MAX_SLOTS;
+    if (hf15InventorySlot(mask, 0, out, slots) < 0)
+    {
+        hf15InventorySplit(mask, 0, out, slots);
+    }
+    if (slots == 0)
+    {
+        PN532_LOGW("ISO15693 inventory stopped after %u slots", (unsigned)HF15_INVENTORY_MAX_SLOTS);
+    }
+    return out.size();
+}
+
+void PN532::hf15InventorySplit(uint8_t *mask, uint8_t maskBits, PN532_TagList<Iso15Target> &out, uint16_t &slots)
+{
+    // The next four UID bits pick the slot; a slot where tags still collide
+    // is split again on the four bits after it
+    if (maskBits + 4 > 64)
+    {
+        return;
+    }
+    uint8_t shift = maskBits % 8;
+    uint8_t &nibble = mask[maskBits / 8];
+    for (uint8_t slot = 0; slot < 16 && slots > 0; slot++)
+    {
+        nibble = (nibble & ~(0x0F << shift)) | (slot << shift);
+        if (hf15InventorySlot(mask, maskBits + 4, out, slots) < 0)
+        {
+            hf15InventorySplit(mask, maskBits + 4, out, slots);
+        }
+    }
+    nibble &= ~(0x0F << shift);
+}
+
+int PN532::hf15InventorySlot(const uint8_t *mask, uint8_t maskBits, PN532_TagList<Iso15Target> &out, uint16_t &slots)
+{
+    // Req ack, tag number, then flags (high data rate, inventory, one slot),
+    // INVENTORY, mask length, mask LSB first and the CRC
+    uint8_t request[5 + 8 + 2] = {0x80, 0x00, 0x26, 0x01, maskBits};
+    size_t maskBytes = (maskBits + 7) / 8;
+    memcpy(request + 5, mask, maskBytes);
+    PN532_Crc::append15693(request + 2, 3 + maskBytes);
+    slots--;
+    if (!writeCommand(InCommunicateThru, request, 5 + maskBytes + 2) || cmdResponse.dataSize < 1)
+    {
+        return 0;
+    }
+
+    const uint8_t *reply = cmdResponse.data + 1;
+    size_t length = cmdResponse.dataSize - 1;
+    uint8_t status = cmdResponse.data[0] & 0x3F;
+    if (status == STATUS_COLLISION)
+    {
+        return -1;
+    }
+    if (status != 0x00)
+    {
+        // Nobody answered, or an RF error; splitting would not help either
+        if (status != STATUS_TIMEOUT && _debug)
+            PN532_LOGD("ISO15693 inventory slot failed, status %02X", status);
+        return 0;
+    }
+    // Flags, DSFID, UID LSB first, CRC; anything else is overlapping answers
+    if (!PN532_Crc::verify15693(reply, length))
+    {
+        return -1;
+    }
+    if (reply[0] & 0x01)
+    {
+        return 0; // error flag
+    }
+    if (length != 12)
+    {
+        return -1;
+    }
+    Iso15Target target;
+    target.dsfid = reply[1];
+    std::reverse_copy(reply + 2, reply + 10, target.uid);
+    out.add(target);
+    return 1;
+}
+
+std::vector<uint8_t>
+PN532::sendHf15Data(std::vector<uint8_t> data, bool append_crc, bool no_check_response)
+{
+    if (append_crc)
+    {
+        appendCrc16Ccitt(data);
+    }
+
+    uint8_t req_ack = no_check_response ? 0x00 : 0x80;
+
+    data.insert(data.begin(), 0);       // insert tag number
+    data.insert(data.begin(), req_ack); // insert req ack
+
+    writeCommand(InCommunicateThru, data.data(), data.size());
+    if (append_crc)
+    {
+        checkCardCrc(true);
+    }
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+PN532::Iso15TagInfo PN532::parseHf15TagInfo(uint8_t *data, size_t dataSize)
+{
+    // Status, flags, info flags, UID LSB first, then the fields the info
+    // flags announce: DSFID, AFI, memory size, IC reference; CRC last
+    PN532::Iso15TagInfo tagInfo = {};
+    if (dataSize < 13 || (data[1] & 0x01))
+    {
+        return tagInfo;
+    }
+    uint8_t info = data[2];
+    size_t end = dataSize - 2;
+    size_t offset = 11;
+    if (offset + ((info & 0x01) != 0) + ((info & 0x02) != 0) + ((info & 0x04) ? 2 : 0) + ((info & 0x08) != 0) > end)
+    {
+        return tagInfo;
+    }
+    tagInfo.uid.assign(data + 3, data + 11);
+    std::reverse(tagInfo.uid.begin(), tagInfo.uid.end());
+    tagInfo.uid_hex = bytes2HexString(&tagInfo.uid, tagInfo.uid.size());
+    if (info & 0x01)
+    {
+        tagInfo.dsfid = data[offset++];
+    }
+    if (info & 0x02)
+    {
+        tagInfo.afi = data[offset++];
+    }
+    if (info & 0x04)
+    {
+        tagInfo.blockCount = data[offset] + 1;
+        tagInfo.blockSize = (data[offset + 1] & 0x1F) + 1;
+        offset += 2;
+    }
+    if (info & 0x08)
+    {
+        tagInfo.icRef = data[offset];
+    }
+    return tagInfo;
+}
+
+PN532::Iso15TagInfo PN532::hf15Info()
+{
+    std::vector<uint8_t> result = sendHf15Data({0x02, 0x2B}, true, false);
+    return parseHf15TagInfo(result.data(), result.size());
+}
+
+std::vector<uint8_t> PN532::hf15Rdbl(uint8_t block)
+{
+    std::vector<uint8_t> readBlockCommands = {0x01, 0x20, block};
+    bool res = writeCommand(InDataExchange, readBlockCommands);
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::hf15Rdbl(uint8_t block, uint8_t *out, size_t capacity)
+{
+    writeCommand(InDataExchange, {0x01, 0x20, block});
+    return readResponse(out, capacity);
+}
+
+bool PN532::hf15Wrbl(uint8_t block, std::vector<uint8_t> data)
+{
+    std::vector<uint8_t> writeBlockCommands = {0x01, 0x21, block};
+    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
+    bool res = writeCommand(InDataExchange, writeBlockCommands);
+    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
+}
+
+size_t PN532::hf15ReadBlocks(uint8_t first, uint16_t count, uint8_t blockSize, uint8_t *out, size_t capacity)
+{
+    // Status, flags, data, CRC in one normal frame
+    size_t length = (size_t)count * blockSize;
+    if (count == 0 || count > 256 || length > capacity || length + 4 > PN532_FrameEncoder::MAX_NORMAL_PAYLOAD)
+    {
+        return 0;
+    }
+    std::vector<uint8_t> result;
+    if (count == 1)
+    {
+        result = sendHf15Data({0x02, 0x20, first}, true, false);
+    }
+    else
+    {
+        result = sendHf15Data({0x02, 0x23, first, (uint8_t)(count - 1)}, true, false);
+    }
+    if (result.size() != length + 4 || result[0] != 0x00 || (result[1] & 0x01))
+    {
+        return 0;
+    }
+    memcpy(out, result.data() + 2, length);
+    return length;
+}
+
+bool PN532::hf15WriteBlocks(uint8_t first, uint8_t blockSize, const std::vector<uint8_t> &data)
+{
+    size_t count = blockSize ? data.size() / blockSize : 0;
+    if (count == 0 || count > 256 || data.size() % blockSize)
+    {
+        return false;
+    }
+    std::vector<uint8_t> command = {0x02, 0x24, first, (uint8_t)(count - 1)};
+    command.insert(command.end(), data.begin(), data.end());
+    std::vector<uint8_t> result = sendHf15Data(command, true, false);
+    if (result.size() == 4 && result[0] == 0x00 && result[1] == 0x00)
+    {
+        return true;
+    }
+    // Error code 0x01/0x02: the tag does not know the command, write each block
+    if (count == 1 || result.size() != 5 || result[0] != 0x00 || result[1] != 0x01 || result[2] > 0x02)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        command = {0x02, 0x21, (uint8_t)(first + i)};
+        command.insert(command.end(), data.begin() + i * blockSize, data.begin() + (i + 1) * blockSize);
+        result = sendHf15Data(command, true, false);
+        if (result.size() != 4 || result[0] != 0x00 || result[1] != 0x00)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PN532::hf15Dump(Iso15Dump &out)
+{
+    unsigned long startTime = millis();
+    Iso15TagInfo info = hf15Info();
+    out = {};
+    if (info.uid.empty() || info.blockCount == 0)
+    {
+        return false;
+    }
+    out.blocks = info.blockCount;
+    out.blockSize = info.blockSize;
+    out.data.assign((size_t)out.blocks * out.blockSize, 0x00);
+    out.blockRead.assign(out.blocks, false);
+
+    // Largest chunk the reply frame holds: status, flags, data, CRC
+    uint16_t ceiling = std::min<size_t>(256, (PN532_FrameEncoder::MAX_NORMAL_PAYLOAD - 4) / out.blockSize);
+    uint16_t chunk = ceiling;
+    // The last rejected range is read in halves up to windowEnd. Past it the
+    // chunk grows back, unless every block in it was readable: then the
+    // range was only too long and the smaller chunk is the new ceiling.
+    uint16_t windowEnd = 0;
+    bool windowSkipped = false;
+    uint16_t block = 0;
+    while (block < out.blocks)
+    {
+        uint16_t count = std::min<uint16_t>(chunk, out.blocks - block);
+        uint8_t *dest = out.data.data() + (size_t)block * out.blockSize;
+        out.reads++;
+        if (hf15ReadBlocks(block, count, out.blockSize, dest, out.data.size() - (size_t)block * out.blockSize) > 0)
+        {
+            out.chunk = std::max(out.chunk, count);
+            for (uint16_t i = 0; i < count; i++)
+            {
+                out.blockRead[block + i] = true;
+            }
+            out.blocksRead += count;
+            block += count;
+        }
+        else if (chunk > 1)
+        {
+            windowEnd = block + count;
+            windowSkipped = false;
+            chunk = (chunk + 1) / 2;
+            continue;
+        }
+        else
+        {
+            // Unreadable single block, e.g. read protected
+            block++;
+            windowSkipped = true;
+        }
+
+        if (windowEnd > 0 && block >= windowEnd)
+        {
+            if (windowSkipped)
+            {
+                chunk = ceiling;
+            }
+            else
+            {
+                ceiling = chunk;
+            }
+            windowEnd = 0;
+        }
+    }
+    out.elapsedMs = millis() - startTime;
+    return out.blocksRead == out.blocks;
+}
+
+PN532::LfTagInfo PN532::lfScan()
+{
+    bool res = writeCommand<ListLfFrame>();
+    if (!res)
+    {
+        return PN532::LfTagInfo();
+    }
+    u_int8_t *data = cmdResponse.data;
+    size_t dataSize = cmdResponse.dataSize;
+    return parseLfScan(data, dataSize);
+}
+
+PN532::LfTagInfo PN532::parseLfScan(uint8_t *data, size_t dataSize)
+{
+    // NbTg, Tg, 5 byte EM410x ID; the first target only
+    LfTagInfo tagInfo;
+    if (dataSize < 7 || data[0] == 0)
+    {
+        return tagInfo;
+    }
+    tagInfo.uid.assign(data + 2, data + 7);
+    tagInfo.id_dec = (tagInfo.uid[0] << 24) | (tagInfo.uid[1] << 16) | (tagInfo.uid[2] << 8) | tagInfo.uid[3];
+    tagInfo.uid_hex = bytes2HexString(&tagInfo.uid, 5);
+    return tagInfo;
+}
+
+std::vector<uint8_t> PN532::getData()
+{
+    bool res = writeCommand(TgGetData);
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::getData(uint8_t *out, size_t capacity)
+{
+    writeCommand(TgGetData);
+    return readResponse(out, capacity);
+}
+
+std::vector<uint8_t> PN532::setData(const std::vector<uint8_t> &data)
+{
+    bool res = writeCommand(TgSetData, data);
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::setData(const uint8_t *data, size_t length, uint8_t *out, size_t capacity)
+{
+    writeCommand(TgSetData, data, length);
+    return readResponse(out, capacity);
+}
+
+bool PN532::inRelease() { return writeCommand<ReleaseFrame>(); }
+std::vector<uint8_t> PN532::tgInitAsTarget(const std::vector<uint8_t> &data)
+{
+    bool res = writeCommand(TgInitAsTarget, data);
+    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+}
+
+size_t PN532::tgInitAsTarget(const uint8_t *data, size_t length, uint8_t *out, size_t capacity)
+{
+    writeCommand(TgInitAsTarget, data, length);
+    return readResponse(out, capacity);
+}
+
+uint8_t PN532::dcs(uint8_t *data, size_t length)
+{
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        checksum += data[i];
+    }
+    return (0x00 - checksum) & 0xFF;
+}
+
+void PN532::appendCrcA(std::vector<uint8_t> &data)
+{
+    size_t length = data.size();
+    data.resize(length + 2);
+    PN532_Crc::appendCrcA(data.data(), length);
+}
+
+void PN532::appendCrc16Ccitt(std::vector<uint8_t> &data)
+{
+    size_t length = data.size();
+    data.resize(length + 2);
+    PN532_Crc::append15693(data.data(), length);
+}
+
+bool PN532::checkCardCrc(bool iso15)
+{
+    // Status, then the card reply. A bare ACK/NAK or a failed exchange has no CRC.
+    if (cmdResponse.dataSize < 4 || cmdResponse.data[0] != 0x00)
+    {
+        return true;
+    }
+    const uint8_t *reply = cmdResponse.data + 1;
+    size_t length = cmdResponse.dataSize - 1;
+    if (iso15 ? PN532_Crc::verify15693(reply, length) : PN532_Crc::verifyA(reply, length))
+    {
+        return true;
+    }
+    metrics.recordCrcError();
+    PN532_LOGW("Card reply CRC mismatch, %u bytes dropped", (unsigned)length);
+    cmdResponse.dataSize = 0;
+    return false;
+}
+
+String PN532::bytes2HexString(std::vector<uint8_t> *data, size_t dataSize)
+{
+    String hexString = "";
+    for (size_t i = 0; i < dataSize; i++)
+    {
+        hexString += (*data)[i] < 0x10 ? "0" : "";
+        hexString += String((*data)[i], HEX);
+    }
+    hexString.toUpperCase();
+    return hexString;
+}
+
+std::vector<uint8_t> PN532::hexStringToUint8Array(const std::string &hexString)
+{
+    std::vector<uint8_t> result;
+    if (hexString.length() % 2 != 0)
+    {
+        std::string paddedHexString = "0" + hexString;
+        return hexStringToUint8Array(paddedHexString);
+    }
+
+    for (size_t i = 0; i < hexString.length(); i += 2)
+    {
+        std::string byteString = hexString.substr(i, 2);
+        uint8_t byte = static_cast<uint8_t>(std::stoul(byteString, nullptr, 16));
+        result.push_back(byte);
+    }
+
+    return result;
+}
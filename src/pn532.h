@@ -0,0 +1,400 @@
+/**
+ * @file pn532.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief PN532 protocol engine and command layer
+ * @version 0.0.1
+ * @date 2024-11-06
+ */
+
+ #ifndef PN532_H
+ #define PN532_H
+
+ #include "pn532_crc.h"
+ #include "pn532_frame.h"
+ #include "pn532_inventory.h"
+ #include "pn532_log.h"
+ #include "pn532_metrics.h"
+ #include "pn532_platform.h"
+ #include "pn532_registers.h"
+ #include "pn532_ring.h"
+ #include "pn532_signal.h"
+ #include "pn532_trace.h"
+ #include "pn532_transport.h"
+ #include <array>
+ #include <atomic>
+ #include <functional>
+ #include <initializer_list>
+ #include <string>
+ #include <vector>
+
+ class PN532 {
+ public:
+     uint8_t DATA_PREAMBLE = 0x00;
+     std::array<uint8_t, 2> DATA_START_CODE = {0x00, 0xFF};
+     uint8_t DATA_TIF_SEND = 0xD4;
+     uint8_t DATA_TIF_RECEIVE = 0xD5;
+     uint8_t DATA_POSTAMBLE = 0x00;
+
+     enum Command {
+         Diagnose = 0x00,
+         GetFirmwareVersion = 0x02,
+         ReadRegister = 0x06,
+         WriteRegister = 0x08,
+         SAMConfiguration = 0x14,
+         PowerDown = 0x16,
+         InDataExchange = 0x40,
+         InCommunicateThru = 0x42,
+         InListPassiveTarget = 0x4A,
+         InDeselect = 0x44,
+         InRelease = 0x52,
+         InSelect = 0x54,
+         InAutoPoll = 0x60,
+         TgInitAsTarget = 0x8C,
+         TgGetData = 0x86,
+         TgSetData = 0x8E
+     };
+
+     enum RspStatus {
+         HF_TAG_OK = 0x00,     // IC card operation is successful
+         HF_TAG_NO = 0x01,     // IC card not found
+         HF_ERR_STAT = 0x02,   // Abnormal IC card communication
+         HF_ERR_CRC = 0x03,    // IC card communication verification abnormal
+         HF_COLLISION = 0x04,  // IC card conflict
+         HF_ERR_BCC = 0x05,    // IC card BCC error
+         MF_ERR_AUTH = 0x06,   // MF card verification failed
+         HF_ERR_PARITY = 0x07, // IC card parity error
+         HF_ERR_ATS = 0x08,    // ATS should be present but card NAKed, or ATS too large
+
+         // Some operations with low frequency cards succeeded!
+         LF_TAG_OK = 0x40,
+         // Unable to search for a valid EM410X label
+         EM410X_TAG_NO_FOUND = 0x41,
+
+         // The parameters passed by the BLE instruction are wrong,
+         // or the parameters passed by calling some functions are wrong
+         PAR_ERR = 0x60,
+         // The mode of the current device is wrong, and the corresponding
+         // API cannot be called
+         DEVICE_MODE_ERROR = 0x66,
+         INVALID_CMD = 0x67,
+         SUCCESS = 0x68,
+         NOT_IMPLEMENTED = 0x69,
+         FLASH_WRITE_FAIL = 0x70,
+         FLASH_READ_FAIL = 0x71,
+         INVALID_SLOT_TYPE = 0x72,
+     };
+
+     PN532(PN532_Transport *transport = nullptr, bool debug = false);
+     virtual ~PN532();
+
+     void setTransport(PN532_Transport *transport);
+     PN532_Transport *getTransport() { return _transport; }
+     void writeData(const std::vector<uint8_t> &data);
+
+     // Response timeout per command code, 0 restores the built-in default
+     void setCommandTimeout(Command cmd, uint32_t timeoutMs);
+     uint32_t getCommandTimeout(Command cmd);
+
+     // CIU registers the library writes
+     static const uint16_t REG_TX_MODE = 0x6302;     // bit 7: TxCRCEn
+     static const uint16_t REG_RX_MODE = 0x6303;     // bit 7: RxCRCEn
+     static const uint16_t REG_BIT_FRAMING = 0x633D; // bits 0-2: TxLastBits
+
+     // Writes a CIU register through the shadow cache: writes that would not
+     // change it are dropped, the rest go out as one WriteRegister frame
+     // right before the next command.
+     void writeRegister(uint16_t address, uint8_t value);
+     // Forgets the cached register values, e.g. after the reader was reset
+     void invalidateRegisters() { _registers.invalidate(); }
+
+     void wakeup();
+     bool halt();
+     bool setNormalMode();
+     bool getVersion();
+
+     // status of a CmdResponse answered by a PN532 error frame
+     static const uint8_t FRAME_ERROR = 0x7F;
+     // status of the CmdResponse handed to a request that timed out or whose reply was lost
+     static const uint8_t NO_RESPONSE = 0xFE;
+     // status of the CmdResponse handed to a request that never reached the reader:
+     // the write failed or the link was lost and could not be restored
+     static const uint8_t NOT_SENT = 0xFD;
+
+     // raw holds the received frame from TFI up to, not including, DCS.
+     // Both buffers are sized for the largest extended frame.
+     typedef struct {
+         uint8_t raw[PN532_FrameEncoder::MAX_FRAME_LEN];
+         size_t length;
+         uint16_t command;
+         uint8_t status;
+         uint16_t dataSize;
+         uint8_t data[PN532_FrameEncoder::MAX_PAYLOAD];
+         // Receive path timing in micros(): first notification since the
+         // previous reply, and the notification that completed this one
+         unsigned long firstNotifyUs;
+         unsigned long receivedUs;
+         uint16_t fragments; // notifications in between, both included
+         uint16_t wireBytes; // bytes they carried, ACK frame included
+     } CmdResponse;
+
+     // Response of the last blocking command. Completion callbacks get the
+     // receive slot itself instead, it is not copied here.
+     CmdResponse cmdResponse;
+
+     // Non-owning view of response bytes. A view of the last blocking
+     // response stays valid until the next blocking command, one taken
+     // inside a completion callback only until the callback returns.
+     struct ResponseView {
+         const uint8_t *data;
+         size_t size;
+
+         const uint8_t *begin() const { return data; }
+         const uint8_t *end() const { return data + size; }
+         uint8_t operator[](size_t i) const { return data[i]; }
+         bool empty() const { return size == 0; }
+     };
+     static ResponseView view(const CmdResponse &response) { return {response.data, response.dataSize}; }
+     ResponseView lastResponse() { return view(cmdResponse); }
+
+     // Asynchronous command API. Requests are queued, pre-encoded and sent in
+     // order; each reply is routed to its request by command code and order.
+     // Callbacks run inside process() on the caller's task. They may submit()
+     // more commands but must not call the blocking API.
+     typedef std::function<void(bool success, const CmdResponse &response)> CommandCallback;
+     bool submit(Command cmd, const uint8_t *data, size_t length, CommandCallback callback, uint32_t timeoutMs = 0);
+     bool submit(Command cmd, const std::vector<uint8_t> &data, CommandCallback callback, uint32_t timeoutMs = 0);
+     bool submit(Command cmd, std::initializer_list<uint8_t> data, CommandCallback callback, uint32_t timeoutMs = 0);
+     // Queues a complete frame as is, e.g. PN532_StaticFrame<...>::bytes. It
+     // is not copied and has to stay valid until the request completed.
+     bool submitFrame(const uint8_t *frame, size_t length, CommandCallback callback, uint32_t timeoutMs = 0);
+     template <typename Frame> bool submit(CommandCallback callback, uint32_t timeoutMs = 0)
+     {
+         return submitFrame(Frame::bytes.data(), Frame::bytes.size(), callback, timeoutMs);
+     }
+     // Sends queued frames and completes replies and timeouts, waiting up to
+     // waitMs for progress. Returns the number of requests still queued.
+     size_t process(uint32_t waitMs = 0);
+     // Runs process() until every request completed or timeoutMs expired
+     bool flush(uint32_t timeoutMs);
+     size_t pending() { return _requests.size(); }
+     // Notified on every reply as well, so one task can wait on several readers
+     void setWakeSignal(PN532_Signal *signal) { _wakeSignal = signal; }
+     // Drops queued requests that are not on the air yet; their callbacks run
+     // right away with success = false. Returns how many were dropped.
+     size_t cancel();
+     // Frames allowed on the air at once. Keep 1 unless the bridge queues commands itself.
+     void setPipelineDepth(uint8_t depth);
+     // Parsed frames, produced by the transport receive callback and consumed by checkResponse
+     PN532_SpscRing<PN532::CmdResponse, 8> pn532Responses;
+     // Latency histograms and health counters, see PN532_Metrics
+     PN532_Metrics metrics;
+ #if PN532_TRACE
+     // Every frame written and every chunk received, see PN532_Trace
+     PN532_Trace trace;
+ #endif
+
+     typedef struct {
+         std::vector<uint8_t> atqa;
+         uint8_t sak;
+         uint8_t uidSize;
+         std::vector<uint8_t> uid;
+         String uid_hex;
+         String sak_hex;
+         String atqa_hex;
+         String type;
+     } Iso14aTagInfo;
+     Iso14aTagInfo hf14aTagInfo;
+     Iso14aTagInfo hf14aScan();
+
+     typedef struct {
+         uint8_t atqa[2];
+         uint8_t sak;
+         uint8_t uidSize;
+         uint8_t uid[10];
+     } Iso14aTarget;
+     // PN532 lists at most two ISO14443A targets at once
+     typedef PN532_Inventory<Iso14aTarget, 2> Iso14aInventory;
+     // Lists every ISO14443A target the reader can hold in one round trip.
+     // Returns how many were found.
+     size_t hf14aInventory(PN532_TagList<Iso14aTarget> &out);
+     // InListPassiveTarget reply: NbTg, then Tg, ATQA, SAK, UID length, UID
+     // and the ATS for ISO14443-4 cards, per target
+     static size_t parseHf14aTargets(const uint8_t *data, size_t dataSize, PN532_TagList<Iso14aTarget> &out);
+     bool mfAuth(std::vector<uint8_t> uid, uint8_t block, uint8_t *key, bool useKeyA);
+     std::vector<uint8_t> mfRdbl(uint8_t block);
+     // The overloads taking out/capacity fill a caller buffer with what the
+     // vector versions return, no heap involved. They return the response
+     // length, or 0 if nothing was received or it does not fit into capacity.
+     size_t mfRdbl(uint8_t block, uint8_t *out, size_t capacity);
+     bool mfWrbl(uint8_t block, std::vector<uint8_t> data);
+     bool mfuWrbl(uint8_t block, std::vector<uint8_t> data);
+     std::vector<uint8_t> sendData(std::vector<uint8_t> data, bool append_crc);
+     size_t sendData(const uint8_t *data, size_t length, bool append_crc, uint8_t *out, size_t capacity);
+     std::vector<uint8_t> send7bit(std::vector<uint8_t> data);
+     bool isGen1A();
+     bool selectTag();
+     bool isGen3();
+     bool isGen4(std::string pwd);
+
+     typedef struct {
+         std::vector<uint8_t> uid;
+         String uid_hex;
+         uint8_t dsfid;
+         uint8_t afi;
+         uint8_t icRef;
+         uint8_t blockSize;
+         uint16_t blockCount;
+     } Iso15TagInfo;
+     Iso15TagInfo hf15TagInfo;
+     std::vector<uint8_t> sendHf15Data(std::vector<uint8_t> data, bool append_crc, bool no_check_response);
+     Iso15TagInfo hf15Scan();
+
+     typedef struct {
+         uint8_t uid[8]; // MSB first, as displayed
+         uint8_t dsfid;
+     } Iso15Target;
+     // Finds every ISO15693 tag in the field. A single tag answers the first
+     // inventory; when several collide, 16-slot rounds split them by their
+     // UID bits, one round trip per slot, until each answers alone. Only a
+     // collision is split, and at most 256 slots are tried.
+     // Returns how many were found, see out.overflowed() for the rest.
+     size_t hf15Inventory(PN532_TagList<Iso15Target> &out);
+     Iso15TagInfo hf15Info();
+     std::vector<uint8_t> hf15Rdbl(uint8_t block);
+     size_t hf15Rdbl(uint8_t block, uint8_t *out, size_t capacity);
+     bool hf15Wrbl(uint8_t block, std::vector<uint8_t> data);
+     // Read/Write Multiple Blocks through sendHf15Data. hf15ReadBlocks copies
+     // count blocks of blockSize bytes to out and returns the bytes copied,
+     // 0 if the tag refused or the data does not fit. hf15WriteBlocks writes
+     // data.size() / blockSize blocks from first, block by block for tags
+     // without Write Multiple Blocks.
+     size_t hf15ReadBlocks(uint8_t first, uint16_t count, uint8_t blockSize, uint8_t *out, size_t capacity);
+     bool hf15WriteBlocks(uint8_t first, uint8_t blockSize, const std::vector<uint8_t> &data);
+
+     typedef struct {
+         std::vector<uint8_t> data;   // blockSize bytes per block
+         std::vector<bool> blockRead; // false where the block could not be read
+         uint16_t blocks;
+         uint16_t blocksRead;
+         uint8_t blockSize;
+         uint16_t chunk; // blocks per read the tag accepted
+         uint16_t reads; // round trips
+         unsigned long elapsedMs;
+     } Iso15Dump;
+     // Reads the whole tag listed by hf15Scan(), sized by hf15Info(). Reads
+     // as many blocks per frame as fit. A rejected range is read again in
+     // halves, down to single blocks; past it, the chunk grows back unless
+     // the range was only too long. Returns true when every block was read.
+     bool hf15Dump(Iso15Dump &out);
+
+     std::vector<uint8_t> getData();
+     size_t getData(uint8_t *out, size_t capacity);
+     std::vector<uint8_t> setData(const std::vector<uint8_t> &data);
+     size_t setData(const uint8_t *data, size_t length, uint8_t *out, size_t capacity);
+     bool inRelease();
+     std::vector<uint8_t> tgInitAsTarget(const std::vector<uint8_t> &data);
+     size_t tgInitAsTarget(const uint8_t *data, size_t length, uint8_t *out, size_t capacity);
+
+     typedef struct {
+         std::vector<uint8_t> uid;
+         String uid_hex;
+         int id_dec;
+     } LfTagInfo;
+     LfTagInfo lfTagInfo;
+
+     LfTagInfo lfScan();
+
+     uint8_t mifareDefaultKey[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+     uint8_t mifareKey[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+ protected:
+     PN532_Transport *_transport = nullptr;
+     bool _debug = false;
+
+ private:
+     // Host benchmarks in extras/bench time the private codec helpers
+     friend class PN532_Benchmark;
+
+     typedef struct {
+         uint8_t frame[PN532_FrameEncoder::MAX_FRAME_SIZE];
+         const uint8_t *wire; // frame, or a constant frame submitted as is
+         size_t frameLength;
+         uint8_t command;
+         uint32_t timeoutMs;
+         unsigned long sentAt;
+         unsigned long sentAtUs;
+         bool cancelled;
+         bool notSent;
+         CommandCallback callback;
+     } AsyncRequest;
+
+     PN532_FrameParser _parser;
+     // Receive path only: notifications since the last reply
+     unsigned long _rxFirstUs = 0;
+     uint16_t _rxFragments = 0;
+     uint16_t _rxBytes = 0;
+     // Set by recoverLink, the receive path drops what it had parsed so far
+     std::atomic<bool> _rxReset{false};
+     PN532_SpscRing<AsyncRequest, 8> _requests;
+     size_t _inFlight = 0;
+     uint8_t _pipelineDepth = 1;
+     int _callbackDepth = 0;
+     CmdResponse _noResponse = {};
+     PN532_Signal _responseSignal;
+     PN532_Signal *_wakeSignal = nullptr;
+     uint16_t _commandTimeouts[256] = {};
+     PN532_RegisterCache _registers;
+
+     bool writeCommand(Command cmd, const uint8_t *data = nullptr, size_t length = 0);
+     bool writeCommand(Command cmd, const std::vector<uint8_t> &data);
+     bool writeCommand(Command cmd, std::initializer_list<uint8_t> data);
+     bool writeFrame(const uint8_t *frame, size_t length);
+     bool execute(Command cmd, const uint8_t *data, size_t length, bool prebuilt);
+     bool enqueue(
+         Command cmd, const uint8_t *data, size_t length, bool prebuilt, CommandCallback callback, uint32_t timeoutMs
+     );
+     template <typename Frame> bool writeCommand() { return writeFrame(Frame::bytes.data(), Frame::bytes.size()); }
+
+     // Commands with a fixed payload, built at compile time
+     typedef PN532_StaticFrame<GetFirmwareVersion> GetFirmwareVersionFrame;
+     typedef PN532_StaticFrame<SAMConfiguration, 0x01> NormalModeFrame;
+     typedef PN532_StaticFrame<InListPassiveTarget, 0x01, 0x00> ListIso14aFrame;
+     typedef PN532_StaticFrame<InListPassiveTarget, 0x01, 0x05> ListIso15Frame;
+     typedef PN532_StaticFrame<InListPassiveTarget, 0x02, 0x00> ListIso14aAllFrame;
+     typedef PN532_StaticFrame<InListPassiveTarget, 0x01, 0x06> ListLfFrame;
+     typedef PN532_StaticFrame<InRelease, 0x00> ReleaseFrame;
+     bool flushRegisters();
+     void forgetRegisters(const uint8_t *data, size_t length);
+     void sendQueued();
+     void recoverLink();
+     void wake();
+     bool dispatchResponse(CmdResponse *rsp);
+     bool expireRequests();
+     void completeRequest(bool success, const CmdResponse *response);
+     void copyResponse(const CmdResponse &from, CmdResponse &to);
+     size_t readResponse(uint8_t *out, size_t capacity);
+     void onReceive(const uint8_t *pData, size_t length);
+     void handleFrame(const uint8_t *frame, size_t length, bool isError);
+
+     bool resetRegister();
+
+     Iso14aTagInfo parseHf14aScan(uint8_t *data, size_t dataSize);
+     String getTagType();
+     String getHf14aTagType();
+     Iso15TagInfo parseHf15Scan(uint8_t *data, size_t dataSize);
+     int hf15InventorySlot(const uint8_t *mask, uint8_t maskBits, PN532_TagList<Iso15Target> &out, uint16_t &slots);
+     void hf15InventorySplit(uint8_t *mask, uint8_t maskBits, PN532_TagList<Iso15Target> &out, uint16_t &slots);
+     Iso15TagInfo parseHf15TagInfo(uint8_t *data, size_t dataSize);
+     String getHf15TagType();
+     LfTagInfo parseLfScan(uint8_t *data, size_t dataSize);
+
+     uint8_t dcs(uint8_t *data, size_t length);
+     void appendCrcA(std::vector<uint8_t> &data);
+     void appendCrc16Ccitt(std::vector<uint8_t> &data);
+     // Drops the last reply if it carries a card CRC that does not match
+     bool checkCardCrc(bool iso15);
+     String bytes2HexString(std::vector<uint8_t> *data, size_t dataSize);
+     std::vector<uint8_t> hexStringToUint8Array(const std::string &hexString);
+ };
+
+ #endif // PN532_H
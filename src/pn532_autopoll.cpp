@@ -0,0 +1,239 @@
+/**
+ * @file pn532_autopoll.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Reader side polling with InAutoPoll and tag arrival/departure events
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_autopoll.h"
+
+namespace
+{
+    // InAutoPoll target types
+    const uint8_t TYPE_JEWEL = 0x04;
+    const uint8_t TYPE_MIFARE = 0x10;
+    const uint8_t TYPE_FELICA_212 = 0x11;
+    const uint8_t TYPE_FELICA_424 = 0x12;
+    const uint8_t TYPE_ISO14443_4A = 0x20;
+    const uint8_t TYPE_ISO14443_4B = 0x23;
+
+    const uint16_t PERIOD_UNIT_MS = 150;
+}
+
+PN532_AutoPoll::~PN532_AutoPoll()
+{
+    stop();
+    if (_inFlight)
+    {
+        _nfc.flush(timeoutMs());
+    }
+}
+
+bool PN532_AutoPoll::start(const Config &config, EventCallback callback)
+{
+    _config = config;
+    _callback = callback;
+
+    // PollNr, Period, then the types; ISO14443-4A first so those cards are
+    // reported with their ATS rather than as plain MIFARE
+    uint32_t period = ((uint32_t)config.periodMs + PERIOD_UNIT_MS / 2) / PERIOD_UNIT_MS;
+    _payload[0] = std::max<uint8_t>(std::min<uint8_t>(config.pollCount, 0xFE), 1);
+    _payload[1] = (uint8_t)std::max<uint32_t>(std::min<uint32_t>(period, 15), 1);
+    _payloadLength = 2;
+    if (config.technologies & TechIso14443A)
+    {
+        _payload[_payloadLength++] = TYPE_ISO14443_4A;
+        _payload[_payloadLength++] = TYPE_MIFARE;
+    }
+    if (config.technologies & TechIso14443B)
+    {
+        _payload[_payloadLength++] = TYPE_ISO14443_4B;
+    }
+    if (config.technologies & TechFelica)
+    {
+        _payload[_payloadLength++] = TYPE_FELICA_212;
+        _payload[_payloadLength++] = TYPE_FELICA_424;
+    }
+    if (config.technologies & TechJewel)
+    {
+        _payload[_payloadLength++] = TYPE_JEWEL;
+    }
+    if (_payloadLength == 2)
+    {
+        return false;
+    }
+
+    _running = true;
+    // A poll still in flight from before keeps the loop going
+    return _inFlight || submitPoll();
+}
+
+uint32_t PN532_AutoPoll::timeoutMs()
+{
+    // Every round polls each type once per period
+    return (uint32_t)_payload[0] * _payload[1] * PERIOD_UNIT_MS * (_payloadLength - 2) + 1000;
+}
+
+bool PN532_AutoPoll::submitPoll()
+{
+    _inFlight = _nfc.submit(
+        PN532::InAutoPoll, _payload, _payloadLength,
+        [this](bool success, const PN532::CmdResponse &response) { onReply(success, response); }, timeoutMs());
+    if (!_inFlight)
+    {
+        _running = false;
+    }
+    return _inFlight;
+}
+
+void PN532_AutoPoll::onReply(bool success, const PN532::CmdResponse &response)
+{
+    _inFlight = false;
+
+    // Polling again would fail the same way at once, leave it to the caller
+    if (!success && response.status == PN532::NOT_SENT)
+    {
+        _running = false;
+        if (_callback)
+        {
+            Tag none = {};
+            _callback(EventStopped, none);
+        }
+        return;
+    }
+
+    // A timeout or error frame counts as a poll that saw nothing
+    Tag seen[2];
+    size_t seenCount = 0;
+    if (success && response.status == PN532::HF_TAG_OK)
+    {
+        seenCount = parse(response.data, response.dataSize, seen, 2);
+    }
+
+    for (size_t i = 0; i < _count;)
+    {
+        bool present = false;
+        for (size_t j = 0; j < seenCount && !present; j++)
+        {
+            present = sameTag(_tags[i].tag, seen[j]);
+        }
+        if (present || ++_tags[i].misses < _config.departAfter)
+        {
+            _tags[i].misses = present ? 0 : _tags[i].misses;
+            i++;
+            continue;
+        }
+        Tag gone = _tags[i].tag;
+        _tags[i] = _tags[--_count];
+        if (_callback)
+        {
+            _callback(EventDeparted, gone);
+        }
+    }
+
+    for (size_t j = 0; j < seenCount; j++)
+    {
+        bool known = false;
+        for (size_t i = 0; i < _count && !known; i++)
+        {
+            known = sameTag(_tags[i].tag, seen[j]);
+        }
+        if (known || _count == MAX_TAGS)
+        {
+            continue;
+        }
+        _tags[_count].tag = seen[j];
+        _tags[_count].misses = 0;
+        _count++;
+        if (_callback)
+        {
+            _callback(EventArrived, seen[j]);
+        }
+    }
+
+    if (_running)
+    {
+        submitPoll();
+    }
+}
+
+size_t PN532_AutoPoll::parse(const uint8_t *data, size_t length, Tag *tags, size_t capacity)
+{
+    if (length < 1)
+    {
+        return 0;
+    }
+    size_t count = 0;
+    size_t offset = 1;
+    for (uint8_t target = 0; target < data[0] && offset + 2 <= length && count < capacity; target++)
+    {
+        uint8_t type = data[offset];
+        size_t targetLength = data[offset + 1];
+        const uint8_t *p = data + offset + 2;
+        offset += 2 + targetLength;
+        if (offset > length)
+        {
+            break;
+        }
+
+        Tag &tag = tags[count];
+        memset(&tag, 0, sizeof(tag));
+        tag.type = type;
+        const uint8_t *uid = nullptr;
+        size_t uidLength = 0;
+        switch (type)
+        {
+        case TYPE_MIFARE:
+        case TYPE_ISO14443_4A:
+            // Tg, SENS_RES, SEL_RES, NFCID1 length, NFCID1, ATS
+            if (targetLength >= 5 && targetLength >= 5u + p[4])
+            {
+                tag.atqa[0] = p[1];
+                tag.atqa[1] = p[2];
+                tag.sak = p[3];
+                uid = p + 5;
+                uidLength = p[4];
+            }
+            break;
+        case TYPE_FELICA_212:
+        case TYPE_FELICA_424:
+            // Tg, POL_RES length, 0x01, NFCID2, PAD, system code
+            if (targetLength >= 11)
+            {
+                uid = p + 3;
+                uidLength = 8;
+            }
+            break;
+        case TYPE_ISO14443_4B:
+            // Tg, ATQB (0x50, PUPI, ...), ATTRIB_RES length, ATTRIB_RES
+            if (targetLength >= 6)
+            {
+                uid = p + 2;
+                uidLength = 4;
+            }
+            break;
+        case TYPE_JEWEL:
+            // Tg, SENS_RES, JEWELID
+            if (targetLength >= 7)
+            {
+                uid = p + 3;
+                uidLength = 4;
+            }
+            break;
+        }
+        if (!uid || uidLength > sizeof(tag.uid))
+        {
+            continue;
+        }
+        memcpy(tag.uid, uid, uidLength);
+        tag.uidLength = uidLength;
+        count++;
+    }
+    return count;
+}
+
+bool PN532_AutoPoll::sameTag(const Tag &a, const Tag &b)
+{
+    return a.uidLength == b.uidLength && memcmp(a.uid, b.uid, a.uidLength) == 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file pn532_autopoll.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Reader side polling with InAutoPoll and tag arrival/departure events
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_AUTOPOLL_H
+ #define PN532_AUTOPOLL_H
+
+ #include "pn532.h"
+
+ // Keeps one InAutoPoll queued at all times, so the PN532 polls the selected
+ // technologies itself and the host only hears from it when a poll ends.
+ // Each reply is compared with the tags seen before: new ones raise
+ // EventArrived, ones missing from departAfter replies in a row EventDeparted.
+ // A poll that cannot be sent stops polling and raises EventStopped.
+ // Replies are handled inside nfc.process(), which the caller keeps running:
+ //     PN532_AutoPoll poller(nfc);
+ //     poller.start(config, [](PN532_AutoPoll::Event event, const PN532_AutoPoll::Tag &tag) { ... });
+ //     while (true) nfc.process(100);
+ // Other commands queue behind the poll in flight. InAutoPoll only covers
+ // the standard PN532 types, ISO15693 and LF still need hf15Scan()/lfScan().
+ class PN532_AutoPoll {
+ public:
+     // Bits of Config::technologies
+     static const uint8_t TechIso14443A = 0x01; // MIFARE, NTAG, ISO14443-4A
+     static const uint8_t TechIso14443B = 0x02;
+     static const uint8_t TechFelica = 0x04; // 212 and 424 kbps
+     static const uint8_t TechJewel = 0x08;
+
+     // PN532 returns at most two targets per poll; more are tracked for
+     // the departAfter window
+     static const size_t MAX_TAGS = 4;
+
+     enum Event {
+         EventArrived,
+         EventDeparted,
+         EventStopped, // the poll was not sent, tag is empty; start() again once connected
+     };
+
+     typedef struct {
+         uint8_t type;      // InAutoPoll target type, e.g. 0x10 MIFARE, 0x20 ISO14443-4A
+         uint8_t uidLength; // NFCID1, NFCID2, PUPI or Jewel ID
+         uint8_t uid[10];
+         uint8_t atqa[2]; // ISO14443A only
+         uint8_t sak;     // ISO14443A only
+     } Tag;
+
+     typedef struct {
+         uint8_t technologies = TechIso14443A;
+         uint16_t periodMs = 150; // between polls, in 150 ms steps up to 2250
+         uint8_t pollCount = 2;   // polls per InAutoPoll before it answers empty
+         uint8_t departAfter = 2; // empty answers before a tag counts as gone
+     } Config;
+
+     typedef std::function<void(Event event, const Tag &tag)> EventCallback;
+
+     PN532_AutoPoll(PN532 &nfc) : _nfc(nfc) {}
+     // Waits for a poll still in flight, its reply refers to this object
+     ~PN532_AutoPoll();
+
+     // Queues the first InAutoPoll. Returns false if it could not be queued.
+     bool start(const Config &config, EventCallback callback);
+     // No new poll is queued; one already in flight still completes
+     void stop() { _running = false; }
+     bool isRunning() const { return _running; }
+
+     // Tags currently in the field
+     size_t tagCount() const { return _count; }
+     const Tag &tag(size_t index) const { return _tags[index].tag; }
+
+     // Decodes an InAutoPoll reply (NbTg, then Type, length, data per
+     // target). Returns the number of tags written, at most capacity.
+     static size_t parse(const uint8_t *data, size_t length, Tag *tags, size_t capacity);
+
+ private:
+     typedef struct {
+         Tag tag;
+         uint8_t misses;
+     } Entry;
+
+     PN532 &_nfc;
+     Config _config;
+     EventCallback _callback;
+     bool _running = false;
+     bool _inFlight = false;
+     Entry _tags[MAX_TAGS];
+     size_t _count = 0;
+     uint8_t _payload[2 + 6];
+     size_t _payloadLength = 0;
+
+     uint32_t timeoutMs();
+     bool submitPoll();
+     void onReply(bool success, const PN532::CmdResponse &response);
+     static bool sameTag(const Tag &a, const Tag &b);
+ };
+
+ #endif // PN532_AUTOPOLL_H
@@ -7,863 +7,686 @@
  */
 
 #include "pn532_ble.h"
+#include <algorithm>
 #include <stdexcept>
 
-PN532_BLE::PN532_BLE(bool debug) { _debug = debug; }
-
-PN532_BLE::~PN532_BLE()
+namespace
 {
-    if (NimBLEDevice::isInitialized())
+    int stackHolders = 0;
+    bool stackStarted = false;
+
+    NimBLEUUID toUuid(const PN532_LinkUuid &uuid) { return NimBLEUUID(uuid.value, uuid.length); }
+
+    // Waits for credits before a write without response is given up
+    const int CREDIT_WAITS = 3;
+
+    void fromUuid(const NimBLEUUID &uuid, PN532_LinkUuid &out)
     {
-        pn532bleBuffer.clear();
-    #if defined(CONFIG_IDF_TARGET_ESP32C5)
-        esp_bt_controller_deinit();
-    #else
-        BLEDevice::deinit();
-    #endif
+        out.length = uuid.getBitSize() / 8;
+        memcpy(out.value, uuid.getValue(), out.length);
     }
 }
 
-class scanCallbacks : public NimBLEScanCallbacks
+// Registered once and kept for the life of the reader, so the host task
+// never runs a callback on a deleted object. Each discovery is a session the
+// host task holds on to while it uses it.
+class PN532_BLE::DiscoveryCallbacks : public NimBLEScanCallbacks
 {
+public:
+    DiscoveryCallbacks(const std::vector<NimBLEUUID> &services) : _services(services) {}
+
+    // An earlier discovery still running reports nullptr to its callback
+    void arm(const DiscoveryFilter &filter, DiscoveryCallback callback)
+    {
+        finish(std::atomic_exchange(&_session, std::make_shared<Session>(filter, callback)));
+    }
+    void disarm() { std::atomic_store(&_session, std::shared_ptr<Session>()); }
+
     void onResult(const NimBLEAdvertisedDevice *advertisedDevice)
     {
-        if (advertisedDevice->getName().find("PN532") != std::string::npos &&
-            advertisedDevice->getName().find("BLE") != std::string::npos)
+        std::shared_ptr<Session> session = std::atomic_load(&_session);
+        if (!session || !matches(*session, advertisedDevice) || session->done.exchange(true))
         {
-            NimBLEDevice::getScan()->stop();
+            return;
         }
+        // Before the callback, which may start the next discovery
+        NimBLEDevice::getScan()->stop();
+        session->callback(advertisedDevice);
     }
-};
 
-bool PN532_BLE::isCompleteFrame(uint8_t *pData, size_t length)
-{
-    if (length < 10)
+    void onScanEnd(const NimBLEScanResults &results, int reason)
     {
-        return false;
+        // A late end of a scan that was restarted meanwhile is not ours
+        if (!NimBLEDevice::getScan()->isScanning())
+        {
+            finish(std::atomic_load(&_session));
+        }
     }
 
-    uint8_t len = pData[9];
-    uint8_t lcs = pData[10];
+private:
+    struct Session {
+        Session(const DiscoveryFilter &filter, DiscoveryCallback callback) : filter(filter), callback(callback) {}
 
-    Serial.print("Length: ");
-    Serial.println(length);
+        DiscoveryFilter filter;
+        DiscoveryCallback callback;
+        std::atomic<bool> done{false};
+    };
 
-    Serial.print("Data Length: ");
-    Serial.println(len);
+    std::vector<NimBLEUUID> _services;
+    std::shared_ptr<Session> _session;
 
-    if (len + 13 < length)
+    static void finish(const std::shared_ptr<Session> &session)
     {
-        Serial.println("Invalid length");
-        return false;
+        if (session && !session->done.exchange(true))
+        {
+            session->callback(nullptr);
+        }
     }
 
-    if ((len + lcs) & 0xFF != 0x00)
+    bool matches(const Session &session, const NimBLEAdvertisedDevice *advertisedDevice)
     {
-        Serial.println("Length checksum failed");
-        pn532bleBuffer.clear();
+        const DiscoveryFilter &filter = session.filter;
+        if (advertisedDevice->getRSSI() < filter.minRssi)
+        {
+            return false;
+        }
+        if (!filter.namePattern.empty() && !matchName(filter.namePattern, advertisedDevice->getName()))
+        {
+            return false;
+        }
+        if (!filter.requireService)
+        {
+            return true;
+        }
+        for (const auto &uuid : _services)
+        {
+            if (advertisedDevice->isAdvertisingService(uuid))
+            {
+                return true;
+            }
+        }
         return false;
     }
+};
 
-    uint8_t dcsValue = pData[length - 2];
+// Tells the protocol engine when the reader went away without being asked to
+class PN532_BLE::LinkCallbacks : public NimBLEClientCallbacks
+{
+public:
+    LinkCallbacks(PN532_BLE &owner) : _owner(owner) {}
 
-    uint8_t calculatedDcs = dcs(pData + 11, len);
-    if (calculatedDcs != dcsValue)
+    void onDisconnect(NimBLEClient *pClient, int reason)
     {
-        Serial.println("Invalid data checksum");
-        return false;
+        PN532_LOGW("Disconnected from %s, reason %d", pClient->getPeerAddress().toString().c_str(), reason);
+        _owner.linkDropped();
     }
 
-    return true;
+private:
+    PN532_BLE &_owner;
+};
+
+PN532_BLE::PN532_BLE(bool debug) : PN532(nullptr, debug)
+{
+    setTransport(this);
+    #if defined(ESP_PLATFORM)
+    esp_timer_create_args_t args = {};
+    args.callback = onIdle;
+    args.arg = this;
+    args.name = "pn532_idle";
+    esp_timer_create(&args, &_idleTimer);
+    #endif
 }
 
-void PN532_BLE::NotifyCallBack(
-    NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify)
+PN532_BLE::~PN532_BLE()
 {
-    // add data to buffer
-    pn532bleBuffer.insert(pn532bleBuffer.end(), pData, pData + length);
-    Serial.print("PN532 ->");
-    for (int i = 0; i < pn532bleBuffer.size(); i++)
+    // The PN532_Transport base is destroyed before ~PN532 runs, let go of it now
+    setTransport(nullptr);
+    #if defined(ESP_PLATFORM)
+    if (_idleTimer)
     {
-        Serial.print(pn532bleBuffer[i] < 0x10 ? " 0" : " ");
-        Serial.print(pn532bleBuffer[i], HEX);
+        esp_timer_stop(_idleTimer);
+        esp_timer_delete(_idleTimer);
     }
-    Serial.println();
-
-    if (!isCompleteFrame(pn532bleBuffer.data(), pn532bleBuffer.size()))
+    #endif
+    if (_discovery)
     {
-        Serial.println("Invalid frame");
-        return;
+        _discovery->disarm();
+        NimBLEScan *pScan = NimBLEDevice::getScan();
+        pScan->stop();
+        pScan->setScanCallbacks(nullptr, false);
     }
-
-    PN532_BLE::CmdResponse rsp;
-    memcpy(rsp.raw, pn532bleBuffer.data(), pn532bleBuffer.size());
-    rsp.length = pn532bleBuffer.size();
-    rsp.command = rsp.raw[12] - 1;
-
-    uint8_t dataSize = rsp.raw[9];
-    rsp.dataSize = dataSize - 2;
-    rsp.command = rsp.raw[12] - 1;
-
-    if (rsp.dataSize > 0)
+    if (_client)
     {
-        memcpy(rsp.data, rsp.raw + 13, rsp.dataSize);
+        _client->setClientCallbacks(nullptr, false);
+        NimBLEDevice::deleteClient(_client);
     }
-
-    pn532Responses.push_back(rsp);
-    pn532bleBuffer.clear();
-}
-
-bool PN532_BLE::searchForDevice()
-{
-    if (_debug)
-        Serial.println("Searching for PN532 BLE device...");
-    NimBLEDevice::init("");
-    NimBLEScan *pScan = NimBLEDevice::getScan();
-    pScan->setScanCallbacks(new scanCallbacks(), false);
-    pScan->setActiveScan(true);
-    if (_debug)
-        Serial.println("Start scanning...");
-    NimBLEScanResults foundDevices = pScan->getResults(5000, false); // 5 seconds in milliseconds
-    if (_debug)
-        Serial.printf("Scan done! Found %d devices.\n", foundDevices.getCount());
-    for (int i = 0; i < foundDevices.getCount(); i++)
+    if (_stackHeld)
     {
-        const NimBLEAdvertisedDevice *advertisedDevice = foundDevices.getDevice(i);
-        if (advertisedDevice->getName().find("PN532") != std::string::npos &&
-            advertisedDevice->getName().find("BLE") != std::string::npos)
-        {
-            _device = *advertisedDevice;
-            return true;
-        }
+        releaseStack();
     }
-    return false;
 }
 
-bool PN532_BLE::isConnected() { return chrWrite != nullptr && chrNotify != nullptr; }
-
-bool PN532_BLE::isPN532Killer() { return _device.getName().find("PN532Killer") != std::string::npos; }
-
-NimBLERemoteService *PN532_BLE::getService(NimBLEClient *pClient)
+void PN532_BLE::acquireStack()
 {
-    for (const auto &uuid : serviceUUIDs)
+    if (stackHolders++ == 0 && !NimBLEDevice::isInitialized())
     {
-        NimBLERemoteService *service = pClient->getService(uuid);
-        if (service)
-        {
-            return service;
-        }
+        NimBLEDevice::init("");
+        stackStarted = true;
     }
-    return nullptr;
 }
 
-bool PN532_BLE::connectToDevice()
+void PN532_BLE::releaseStack()
 {
-    NimBLEClient *pClient = NimBLEDevice::createClient();
-    if (!pClient)
+    if (stackHolders == 0 || --stackHolders > 0 || !stackStarted)
     {
-        Serial.println("Failed to create client");
-        return false;
+        return;
     }
-
-    if (!pClient->connect(&_device, false))
+    stackStarted = false;
+    if (NimBLEDevice::isInitialized())
     {
-        Serial.println("Failed to connect to device");
-        return false;
+    #if defined(CONFIG_IDF_TARGET_ESP32C5)
+        esp_bt_controller_deinit();
+    #else
+        BLEDevice::deinit();
+    #endif
     }
+}
 
-    Serial.print("Connected to: ");
-    Serial.println(pClient->getPeerAddress().toString().c_str());
-
-    delay(200);
-
-    pSvc = getService(pClient);
-    if (!pSvc)
+void PN532_BLE::holdStack()
+{
+    if (!_stackHeld)
     {
-        Serial.println("Service does not exist");
-        return false;
+        acquireStack();
+        _stackHeld = true;
     }
+}
 
-    auto characteristics = pSvc->getCharacteristics(true);
-    Serial.println("Characteristics Size:");
-    Serial.println(characteristics.size());
+bool PN532_BLE::isReaderName(const std::string &name) { return matchName(readerNamePattern(), name); }
 
-    for (auto &characteristic : characteristics)
+bool PN532_BLE::matchName(const std::string &pattern, const std::string &name)
+{
+    // On a mismatch after '*', let the star take one more character and retry
+    size_t p = 0;
+    size_t n = 0;
+    size_t star = std::string::npos;
+    size_t resume = 0;
+    while (n < name.size())
     {
-        if (characteristic->canWrite())
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
         {
-            chrWrite = characteristic;
-            break;
+            p++;
+            n++;
         }
-    }
-    for (auto &characteristic : characteristics)
-    {
-        if (characteristic->canNotify())
+        else if (p < pattern.size() && pattern[p] == '*')
         {
-            chrNotify = characteristic;
-            break;
+            star = p++;
+            resume = n;
+        }
+        else if (star != std::string::npos)
+        {
+            p = star + 1;
+            n = ++resume;
+        }
+        else
+        {
+            return false;
         }
     }
-
-    if (!chrWrite)
+    while (p < pattern.size() && pattern[p] == '*')
     {
-        Serial.println("Write characteristic does not exist");
-        return false;
+        p++;
     }
+    return p == pattern.size();
+}
 
-    if (!chrNotify)
+bool PN532_BLE::startDiscovery(const DiscoveryFilter &filter, DiscoveryCallback callback)
+{
+    holdStack();
+    NimBLEScan *pScan = NimBLEDevice::getScan();
+    pScan->stop();
+    if (!_discovery)
     {
-        Serial.println("Notify characteristic does not exist");
-        return false;
+        _discovery.reset(new DiscoveryCallbacks(serviceUUIDs));
     }
-
-    // Use a lambda to call the non-static NotifyCallBack
-    chrNotify->subscribe(
-        true,
-        [this](
-            NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify)
-        { this->NotifyCallBack(pRemoteCharacteristic, pData, length, isNotify); });
-    return true;
+    _discovery->arm(filter, callback);
+    pScan->setScanCallbacks(_discovery.get(), false);
+    // Readers put their name in the scan response
+    pScan->setActiveScan(true);
+    return pScan->start(filter.timeoutMs, false, true);
 }
 
-bool PN532_BLE::writeCommand(Command cmd, uint8_t *data, size_t length)
+bool PN532_BLE::discover(const DiscoveryFilter &filter)
 {
-    pn532bleBuffer.clear();
-
-    if (data == nullptr)
+    if (_debug)
+        PN532_LOGD("Searching for PN532 BLE device...");
+    _discovered = false;
+    _discoverySignal.wait(0);
+    bool started = startDiscovery(
+        filter,
+        [this](const NimBLEAdvertisedDevice *device)
+        {
+            if (device)
+            {
+                _device = *device;
+                _name.clear();
+                _discovered = true;
+            }
+            _discoverySignal.notify();
+        });
+    if (!started)
     {
-        data = new uint8_t[0];
+        PN532_LOGE("Failed to start scanning");
+        return false;
     }
-
-    std::vector<uint8_t> commands;
-    commands.push_back(DATA_TIF_SEND);
-    commands.push_back(cmd);
-    commands.insert(commands.end(), data, data + length);
-
-    std::vector<uint8_t> frame;
-    frame.push_back(DATA_PREAMBLE);
-    frame.insert(frame.end(), std::begin(DATA_START_CODE), std::end(DATA_START_CODE));
-
-    uint8_t len = commands.size();
-    uint8_t length_check_sum = (0x00 - len) & 0xFF;
-    frame.push_back(len);
-    frame.push_back(length_check_sum);
-    frame.insert(frame.end(), commands.begin(), commands.end());
-
-    uint8_t dcs_value = dcs(commands.data(), commands.size());
-    frame.push_back(dcs_value);
-    frame.push_back(DATA_POSTAMBLE);
-
-    Serial.print("PN532 <-");
-    for (int i = 0; i < frame.size(); i++)
+    // The scan ends by itself after timeoutMs, the margin covers stopping it
+    if (!_discoverySignal.wait(filter.timeoutMs + 500))
     {
-        Serial.print(frame[i] < 0x10 ? " 0" : " ");
-        Serial.print(frame[i], HEX);
+        NimBLEDevice::getScan()->stop();
     }
-    Serial.println();
-    bool writeRes = chrWrite->writeValue(frame.data(), frame.size(), true);
-    delay(10);
-
-    bool res = checkResponse(uint8_t(cmd));
-    return writeRes && res;
+    if (_debug)
+        PN532_LOGD("Scan done, %s", _discovered ? _device.getName().c_str() : "no reader found");
+    return _discovered;
 }
 
-bool PN532_BLE::writeCommand(Command cmd, const std::vector<uint8_t> &data)
+bool PN532_BLE::searchForDevice() { return discover(DiscoveryFilter()); }
+
+NimBLEAddress PN532_BLE::getAddress()
 {
-    return writeCommand(cmd, const_cast<uint8_t *>(data.data()), data.size());
+    return _client && _client->isConnected() ? _client->getPeerAddress() : _device.getAddress();
 }
 
-bool PN532_BLE::checkResponse(uint8_t cmd)
+bool PN532_BLE::isConnected() { return chrWrite != nullptr && chrNotify != nullptr && !linkLost(); }
+
+bool PN532_BLE::write(const uint8_t *data, size_t length)
 {
-    unsigned long startTime = millis();
-    while (pn532Responses.empty())
+    if (linkLost() && !restoreLink())
+    {
+        return false;
+    }
+    if (!chrWrite)
+    {
+        return false;
+    }
+    busy();
+    // A reply to an earlier frame already refilled the credits
+    _creditSignal.wait(0);
+    // Longer frames go out as several writes, which the bridge joins like any
+    // other byte stream; a prepared long write would cost extra round trips
+    size_t chunk = std::max<uint16_t>(_client->getMTU(), BLE_ATT_MTU_DFLT) - 3;
+    for (size_t offset = 0; offset < length; offset += chunk)
     {
-        if (millis() - startTime > 4000)
+        if (!writeChunk(data + offset, std::min(chunk, length - offset)))
         {
-            Serial.println("Timeout out");
             return false;
         }
-        delay(10);
-        if (_debug)
-        {
-            Serial.print(".");
-        }
     }
+    return true;
+}
 
-    auto it = std::find_if(pn532Responses.begin(), pn532Responses.end(), [cmd](const CmdResponse &response)
-                           { return response.command == cmd; });
-
-    if (it != pn532Responses.end())
+bool PN532_BLE::writeChunk(const uint8_t *data, size_t length)
+{
+    // Without response while credits last
+    if (_noResponse && _credits > 0 && chrWrite->writeValue(data, length, false))
     {
-        cmdResponse = *it;
+        _credits--;
+        return true;
     }
-    else
+    if (_noResponse && !_withResponse)
     {
-        if (_debug)
+        // Nothing confirms a write, wait for a reply or until the packets
+        // queued so far had two connection events to go out
+        for (int i = 0; i < CREDIT_WAITS; i++)
         {
-            Serial.println("No matching response found.");
+            _creditSignal.wait(creditWaitMs());
+            _credits = _tuning.credits;
+            if (chrWrite->writeValue(data, length, false))
+            {
+                _credits--;
+                return true;
+            }
         }
         return false;
     }
-    // cmdResponse = pn532Responses[0];
-    if (_debug)
+    // One write with response makes sure the reader took everything before it
+    if (!chrWrite->writeValue(data, length, true))
     {
-        Serial.print("PN532 Response: ");
-        for (int i = 0; i < cmdResponse.length; i++)
-        {
-            Serial.print(cmdResponse.raw[i] < 0x10 ? " 0" : " ");
-            Serial.print(cmdResponse.raw[i], HEX);
-        }
-        Serial.println();
-        // print response command, status, data size and data
-        Serial.print("Response Command: ");
-        Serial.println(cmdResponse.command, HEX);
-        Serial.print("    Status: ");
-        Serial.println(cmdResponse.status, HEX);
-        Serial.print("    Size: ");
-        Serial.println(cmdResponse.dataSize);
-        Serial.print("    Data: ");
-        for (int i = 0; i < cmdResponse.dataSize; i++)
-        {
-            Serial.print(cmdResponse.data[i] < 0x10 ? " 0" : " ");
-            Serial.print(cmdResponse.data[i], HEX);
-        }
-        Serial.println();
+        return false;
     }
-
-    bool success = true;
-
-    // if (success && cmdResponse.command == InListPassiveTarget)
-    // {
-    //     hfTagData.size = cmdResponse.data[0];
-    //     memcpy(hfTagData.uidByte, cmdResponse.data + 1, hfTagData.size);
-
-    //     hfTagData.atqaByte[1] = cmdResponse.data[1 + hfTagData.size];
-    //     hfTagData.atqaByte[0] = cmdResponse.data[2 + hfTagData.size];
-
-    //     hfTagData.sak = cmdResponse.data[3 + hfTagData.size];
-    // }
-
-    pn532Responses.clear();
-    return success;
+    _credits = _tuning.credits;
+    return true;
 }
 
-void PN532_BLE::writeData(const std::vector<uint8_t> &data)
+void PN532_BLE::setLinkTuning(const LinkTuning &tuning)
 {
-    if (chrWrite)
+    _tuning = tuning;
+    if (isConnected())
     {
-        chrWrite->writeValue(data.data(), data.size());
+        tuneLink();
+        requestParams(true);
     }
 }
 
-void PN532_BLE::setDevice(NimBLEAdvertisedDevice device) { _device = device; }
+void PN532_BLE::tuneLink()
+{
+    _withResponse = chrWrite->canWrite();
+    _noResponse = chrWrite->canWriteNoResponse() && (_tuning.writeWithoutResponse || !_withResponse);
+    _credits = _tuning.credits;
+    _client->setDataLen(_tuning.dataLength);
+    // Connected with the fast parameters, relax them when nothing follows
+    _fast = true;
+    busy();
+}
 
-String PN532_BLE::getTagType()
+void PN532_BLE::busy()
 {
-    switch (hf14aTagInfo.sak)
+    #if defined(ESP_PLATFORM)
+    if (_idleTimer && _tuning.idleAfterMs > 0)
+    {
+        esp_timer_stop(_idleTimer);
+        esp_timer_start_once(_idleTimer, (uint64_t)_tuning.idleAfterMs * 1000);
+    }
+    #endif
+    if (!_fast.exchange(true))
     {
-    case 0x09:
-        return "MIFARE Mini";
-    case 0x08:
-    case 0x88:
-        return "MIFARE 1K";
-    case 0x18:
-        return "MIFARE 4K";
-    case 0x00:
-        return "MIFARE Ultralight";
-    default:
-        return "Unknown";
+        requestParams(true);
     }
 }
 
-String PN532_BLE::getHf14aTagType()
+void PN532_BLE::onIdle(void *arg)
 {
-    switch (hf14aTagInfo.sak)
+    PN532_BLE *self = (PN532_BLE *)arg;
+    if (self->_fast.exchange(false) && self->isConnected())
     {
-    case 0x09:
-        return "MIFARE Mini";
-    case 0x08:
-    case 0x88:
-        return "MIFARE 1K";
-    case 0x18:
-        return "MIFARE 4K";
-    case 0x00:
-        return "MIFARE Ultralight";
-    default:
-        return "Unknown";
+        self->requestParams(false);
     }
 }
 
-String PN532_BLE::getHf15TagType() { return "ISO15693"; }
-
-void PN532_BLE::wakeup()
+void PN532_BLE::requestParams(bool fast)
 {
-    writeData(
-        {0x55, 0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+    // The reader may refuse or pick other values, getLinkInfo() has the outcome
+    bool requested = fast ? _client->updateConnParams(
+                                _tuning.fastMinInterval, _tuning.fastMaxInterval, 0, _tuning.supervisionTimeout)
+                          : _client->updateConnParams(
+                                _tuning.idleMinInterval, _tuning.idleMaxInterval, _tuning.idleLatency,
+                                _tuning.supervisionTimeout);
+    if (!requested)
+    {
+        PN532_LOGW("Failed to request %s connection parameters", fast ? "fast" : "idle");
+    }
 }
 
-bool PN532_BLE::setNormalMode()
+uint32_t PN532_BLE::creditWaitMs()
 {
-    wakeup();
-    return writeCommand(SAMConfiguration, {0x01});
+    uint32_t intervalMs = _client->getConnInfo().getConnInterval() * 5 / 4;
+    return std::max<uint32_t>(2 * intervalMs, 2);
 }
 
-bool PN532_BLE::getVersion() { return writeCommand(GetFirmwareVersion); }
-
-PN532_BLE::Iso14aTagInfo PN532_BLE::hf14aScan()
+PN532_BLE::LinkInfo PN532_BLE::getLinkInfo()
 {
-    bool res = writeCommand(InListPassiveTarget, {0x01, 0x00});
-    if (!res)
+    LinkInfo info = {};
+    if (!_client || !_client->isConnected())
     {
-        return PN532_BLE::Iso14aTagInfo();
+        return info;
     }
-    u_int8_t *data = cmdResponse.data;
-    u_int8_t dataSize = cmdResponse.dataSize;
-    return parseHf14aScan(data, dataSize);
+    NimBLEConnInfo conn = _client->getConnInfo();
+    info.mtu = _client->getMTU();
+    info.intervalMs = conn.getConnInterval() * 1.25f;
+    info.latency = conn.getConnLatency();
+    info.supervisionTimeoutMs = conn.getConnTimeout() * 10;
+    info.writeWithoutResponse = _noResponse;
+    info.fast = _fast;
+    return info;
 }
 
-PN532_BLE::Iso14aTagInfo PN532_BLE::parseHf14aScan(uint8_t *data, uint8_t dataSize)
+bool PN532_BLE::restoreLink()
 {
-    hf14aTagInfo.atqa = {data[2], data[3]};
-    hf14aTagInfo.sak = data[4];
-    hf14aTagInfo.uidSize = data[5];
-    hf14aTagInfo.uid.assign(data + 6, data + 6 + hf14aTagInfo.uidSize);
-    hf14aTagInfo.uid_hex = "";
-    for (size_t i = 0; i < hf14aTagInfo.uid.size(); i++)
+    if (!_autoReconnect)
     {
-        hf14aTagInfo.uid_hex += hf14aTagInfo.uid[i] < 0x10 ? "0" : "";
-        hf14aTagInfo.uid_hex += String(hf14aTagInfo.uid[i], HEX);
+        return false;
     }
-    hf14aTagInfo.uid_hex.toUpperCase();
-    hf14aTagInfo.atqa_hex = bytes2HexString(&hf14aTagInfo.atqa, 2);
-    std::vector<uint8_t> sakVector = {hf14aTagInfo.sak};
-    hf14aTagInfo.sak_hex = bytes2HexString(&sakVector, 1);
-    hf14aTagInfo.type = getTagType();
-    return hf14aTagInfo;
+    PN532_LOGW("Link lost, reconnecting");
+    return reconnect();
 }
 
-bool PN532_BLE::mfAuth(std::vector<uint8_t> uid, uint8_t block, uint8_t *key, bool useKeyA)
+bool PN532_BLE::reconnect(uint32_t timeoutMs)
 {
-    std::vector<uint8_t> authData = {0x01};
-    authData.push_back(useKeyA ? 0x60 : 0x61);
-    authData.push_back(block);
-    authData.insert(authData.end(), key, key + 6);
-    uint8_t uidLength = uid.size();
-    authData.insert(authData.end(), uid.end() - 4, uid.end());
-    bool res = writeCommand(InDataExchange, authData);
-    if (!res)
+    if (!_linkKnown && !(_store && _store->load(_link)))
     {
+        PN532_LOGE("No reader to reconnect to");
         return false;
     }
-    return cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
+    _linkKnown = true;
+    return connectToAddress(NimBLEAddress(_link.address, _link.addressType), timeoutMs);
 }
 
-std::vector<uint8_t> PN532_BLE::mfRdbl(uint8_t block)
+bool PN532_BLE::isLinkAddress(const NimBLEAddress &address)
 {
-    std::vector<uint8_t> readBlockCommands = {0x01, 0x30, block};
-    bool res = writeCommand(InDataExchange, readBlockCommands);
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
+    return _linkKnown && address == NimBLEAddress(_link.address, _link.addressType);
 }
 
-bool PN532_BLE::mfWrbl(uint8_t block, std::vector<uint8_t> data)
-{
-    std::vector<uint8_t> writeBlockCommands = {0x01, 0xA0, block};
-    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
-    bool res = writeCommand(InDataExchange, writeBlockCommands);
-    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
-}
-
-bool PN532_BLE::mfuWrbl(uint8_t block, std::vector<uint8_t> data)
-{
-    std::vector<uint8_t> writeBlockCommands = {0x01, 0xA2, block};
-    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
-    bool res = writeCommand(InDataExchange, writeBlockCommands);
-    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
-}
+bool PN532_BLE::isPN532Killer() { return getName().find("PN532Killer") != std::string::npos; }
 
-std::vector<uint8_t> PN532_BLE::sendData(std::vector<uint8_t> data, bool append_crc)
+NimBLERemoteService *PN532_BLE::getService(NimBLEClient *pClient)
 {
-    if (append_crc)
+    for (const auto &uuid : serviceUUIDs)
     {
-        appendCrcA(data);
+        NimBLERemoteService *service = pClient->getService(uuid);
+        if (service)
+        {
+            return service;
+        }
     }
-
-    writeCommand(InCommunicateThru, data.data(), data.size());
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-std::vector<uint8_t> PN532_BLE::send7bit(std::vector<uint8_t> data)
-{
-    writeCommand(WriteRegister, {0x63, 0x3D, 0x07});
-    std::vector<uint8_t> responseData = sendData(data, false);
-    writeCommand(WriteRegister, {0x63, 0x3D, 0x00});
-    return responseData;
-}
-
-bool PN532_BLE::resetRegister() { return writeCommand(WriteRegister, {0x63, 0x02, 0x00, 0x63, 0x03, 0x00}); }
-
-bool PN532_BLE::halt()
-{
-    resetRegister();
-    sendData({0x50, 0x00}, false);
-    return true;
+    return nullptr;
 }
 
-bool PN532_BLE::isGen1A()
+NimBLEClient *PN532_BLE::createClient()
 {
-    halt();
-    std::vector<uint8_t> unlock1 = send7bit({0x40});
-    if (unlock1.size() == 2 && unlock1[1] == 0x0A)
+    holdStack();
+    // One client per reader, reused when connecting again, so the attributes
+    // found on the last connection are still there
+    if (!_client)
     {
-        delay(10);
-        Serial.println("Unlock1 success");
-        std::vector<uint8_t> unlock2 = sendData({0x43}, false);
-        if (unlock2.size() == 2 && unlock2[1] == 0x0A)
+        _client = NimBLEDevice::createClient();
+        if (!_client)
         {
-            delay(10);
-            Serial.println("Unlock2 success");
-            return true;
+            PN532_LOGE("Failed to create client");
+            return nullptr;
         }
+        _linkCallbacks.reset(new LinkCallbacks(*this));
+        _client->setClientCallbacks(_linkCallbacks.get(), false);
     }
-    return false;
+    // Asked for on connect: the MTU by every client of the stack
+    NimBLEDevice::setMTU(_tuning.mtu);
+    _client->setConnectionParams(
+        _tuning.fastMinInterval, _tuning.fastMaxInterval, 0, _tuning.supervisionTimeout);
+    return _client;
 }
 
-bool PN532_BLE::selectTag()
+bool PN532_BLE::connectToDevice()
 {
-    PN532_BLE::Iso14aTagInfo tag_info = hf14aScan();
-    halt();
-    if (tag_info.uid.empty())
+    NimBLEClient *pClient = createClient();
+    if (!pClient)
     {
-        Serial.println("No tag found");
         return false;
     }
-    size_t uid_length = tag_info.uid.size();
-    if (_debug)
-    {
-        Serial.print("Found UID: ");
-        Serial.println(tag_info.uid_hex);
-    }
-
-    std::vector<uint8_t> wupa_result = send7bit({0x52});
-    if (_debug)
-    {
-        Serial.print("WUPA: ");
-        Serial.println(bytes2HexString(&wupa_result, wupa_result.size()));
-    }
 
-    auto anti_coll_result = sendData({0x93, 0x20}, false);
-    if (_debug)
+    if (!pClient->connect(&_device, false))
     {
-        Serial.print("Anticollision CL1: ");
-        Serial.println(bytes2HexString(&anti_coll_result, anti_coll_result.size()));
+        PN532_LOGE("Failed to connect to device");
+        return false;
     }
+    return attach(pClient);
+}
 
-    if (anti_coll_result[0] != 0x00)
+bool PN532_BLE::connectToAddress(const NimBLEAddress &address, uint32_t timeoutMs)
+{
+    NimBLEClient *pClient = createClient();
+    if (!pClient)
     {
-        if (_debug)
-        {
-            Serial.println("Anticollision failed");
-        }
         return false;
     }
 
-    std::vector<uint8_t> anti_coll_data(anti_coll_result.begin() + 1, anti_coll_result.end());
-    std::vector<uint8_t> select_data = {0x93, 0x70};
-    select_data.insert(select_data.end(), anti_coll_data.begin(), anti_coll_data.end());
-    auto select_result = sendData(select_data, true);
-    if (_debug)
+    // A reader that is off fails after timeoutMs instead of the 30 s default
+    pClient->setConnectTimeout(timeoutMs);
+    if (!pClient->connect(address, false))
     {
-        Serial.print("Select CL1: ");
-        Serial.println(bytes2HexString(&select_result, select_result.size()));
+        PN532_LOGE("Failed to connect to %s", address.toString().c_str());
+        return false;
     }
-
-    if (uid_length == 4)
+    // No advertisement to take the name from, isPN532Killer() needs it
+    if (isLinkAddress(address))
     {
-        return select_result.size() > 1 && select_result[0] == 0x00;
+        _name.assign(_link.name, strnlen(_link.name, sizeof(_link.name)));
     }
-    else if (uid_length == 7)
+    else
     {
-        auto anti_coll2_result = sendData({0x95, 0x20}, false);
-        if (_debug)
-        {
-            Serial.print("Anticollision CL2: ");
-            Serial.println(bytes2HexString(&anti_coll2_result, anti_coll2_result.size()));
-        }
-        if (anti_coll2_result[0] != 0x00)
-        {
-            if (_debug)
-            {
-                Serial.println("Anticollision CL2 failed");
-            }
-            return false;
-        }
-        std::vector<uint8_t> anti_coll2_data(anti_coll2_result.begin() + 1, anti_coll2_result.end());
-        std::vector<uint8_t> select2_data = {0x95, 0x70};
-        select2_data.insert(select2_data.end(), anti_coll2_data.begin(), anti_coll2_data.end());
-        auto select2_result = sendData(select2_data, true);
-        if (_debug)
-        {
-            Serial.print("Select CL2: ");
-            Serial.println(bytes2HexString(&select2_result, select2_result.size()));
-        }
-        return select2_result.size() > 1 && select2_result[0] == 0x00;
+        NimBLEAttValue name = pClient->getValue(NimBLEUUID((uint16_t)0x1800), NimBLEUUID((uint16_t)0x2A00));
+        _name.assign((const char *)name.data(), name.size());
     }
-    return false;
+    return attach(pClient);
 }
 
-bool PN532_BLE::isGen3()
+bool PN532_BLE::attach(NimBLEClient *pClient)
 {
-    bool selected = selectTag();
-    if (!selected)
+    PN532_LOGI("Connected to: %s", pClient->getPeerAddress().toString().c_str());
+
+    if (!attachCached(pClient) && !discoverLink(pClient))
     {
         return false;
     }
-    std::vector<uint8_t> result = sendData({0x30, 0x00}, true);
-    return result.size() >= 16;
-}
 
-bool PN532_BLE::isGen4(std::string pwd)
-{
-    bool selected = selectTag();
-    if (!selected)
+    // Use a lambda to call the non-static NotifyCallBack
+    if (!chrNotify->subscribe(
+            true,
+            [this](
+                NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify)
+            { this->NotifyCallBack(pRemoteCharacteristic, pData, length, isNotify); }))
     {
+        PN532_LOGE("Failed to subscribe to notifications");
         return false;
     }
-    std::vector<uint8_t> auth_data = {0xCF};
-    std::vector<uint8_t> pwd_bytes = hexStringToUint8Array(pwd);
-    auth_data.insert(auth_data.end(), pwd_bytes.begin(), pwd_bytes.end());
-    auth_data.push_back(0xC6);
-    std::vector<uint8_t> result = sendData(auth_data, true);
-    return result.size() >= 15;
-}
-
-PN532_BLE::Iso15TagInfo PN532_BLE::hf15Scan()
-{
-    bool res = writeCommand(InListPassiveTarget, {0x01, 0x05});
-    if (!res)
+    rememberLink(pClient);
+    tuneLink();
+    // A new connection may be to a reader that was power cycled meanwhile
+    invalidateRegisters();
+    linkRestored();
+    if (_debug)
     {
-        return PN532_BLE::Iso15TagInfo();
+        LinkInfo info = getLinkInfo();
+        PN532_LOGD(
+            "MTU %u, interval %.2f ms, write %s response", info.mtu, info.intervalMs,
+            info.writeWithoutResponse ? "without" : "with");
     }
-    u_int8_t *data = cmdResponse.data;
-    u_int8_t dataSize = cmdResponse.dataSize;
-    hf15TagInfo = parseHf15Scan(data, dataSize);
-    return hf15TagInfo;
+    return true;
 }
 
-PN532_BLE::Iso15TagInfo PN532_BLE::parseHf15Scan(uint8_t *data, uint8_t dataSize)
+bool PN532_BLE::attachCached(NimBLEClient *pClient)
 {
-    Iso15TagInfo tagInfo;
-    size_t offset = 0;
-
-    if (dataSize < 10)
+    if (!isLinkAddress(pClient->getPeerAddress()))
     {
-        return tagInfo;
+        return false;
     }
-
-    while (offset < dataSize)
+    // Right after a drop the client still holds the attributes and nothing
+    // goes on the air; after a reboot only the cached UUIDs are looked up
+    NimBLERemoteService *service = pClient->getService(toUuid(_link.service));
+    NimBLERemoteCharacteristic *write = service ? service->getCharacteristic(toUuid(_link.write)) : nullptr;
+    NimBLERemoteCharacteristic *notify = service ? service->getCharacteristic(toUuid(_link.notify)) : nullptr;
+    if (!write || !notify || service->getStartHandle() != _link.serviceHandle ||
+        write->getHandle() != _link.writeHandle || notify->getHandle() != _link.notifyHandle)
     {
-        uint8_t tagType = data[offset];
-        offset += 1;
-        uint8_t tagNum = data[offset];
-        offset += 1;
-        std::vector<uint8_t> uid(data + offset, data + offset + 8);
-        offset += 8;
-        std::reverse(uid.begin(), uid.end());
-        tagInfo.uid = uid;
-        tagInfo.uid_hex = bytes2HexString(&uid, 8);
+        PN532_LOGW("Cached GATT handles are stale, discovering again");
+        return false;
     }
-
-    return tagInfo;
+    pSvc = service;
+    chrWrite = write;
+    chrNotify = notify;
+    return true;
 }
 
-std::vector<uint8_t>
-PN532_BLE::sendHf15Data(std::vector<uint8_t> data, bool append_crc, bool no_check_response)
+bool PN532_BLE::discoverLink(NimBLEClient *pClient)
 {
-    if (append_crc)
-    {
-        appendCrc16Ccitt(data);
-    }
+    // Attributes kept from an earlier connection may not match this reader
+    pSvc = nullptr;
+    chrWrite = nullptr;
+    chrNotify = nullptr;
+    pClient->deleteServices();
 
-    uint8_t req_ack = no_check_response ? 0x00 : 0x80;
-
-    data.insert(data.begin(), 0);       // insert tag number
-    data.insert(data.begin(), req_ack); // insert req ack
-
-    writeCommand(InCommunicateThru, data.data(), data.size());
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-PN532_BLE::Iso15TagInfo PN532_BLE::parseHf15TagInfo(uint8_t *data, uint8_t dataSize)
-{
-    PN532_BLE::Iso15TagInfo tagInfo;
-    if (dataSize > 15)
+    pSvc = getService(pClient);
+    if (!pSvc)
     {
-        tagInfo.dsfid = data[11];
-        tagInfo.afi = data[12];
-        tagInfo.blockSize = data[13] + 1;
-        tagInfo.icRef = data[15];
-        tagInfo.uid.assign(data + 3, data + 11);
-        std::reverse(tagInfo.uid.begin(), tagInfo.uid.end());
-        tagInfo.uid_hex = bytes2HexString(&tagInfo.uid, tagInfo.uid.size());
+        PN532_LOGE("Service does not exist");
+        return false;
     }
-    return tagInfo;
-}
 
-PN532_BLE::Iso15TagInfo PN532_BLE::hf15Info()
-{
-    std::vector<uint8_t> result = sendHf15Data({0x02, 0x2B}, true, false);
-    if (result.size() < 16)
+    auto characteristics = pSvc->getCharacteristics(true);
+    PN532_LOGI("Characteristics Size: %u", (unsigned)characteristics.size());
+
+    for (auto &characteristic : characteristics)
     {
-        return PN532_BLE::Iso15TagInfo();
+        if (characteristic->canWrite() || characteristic->canWriteNoResponse())
+        {
+            chrWrite = characteristic;
+            break;
+        }
     }
-    return parseHf15TagInfo(result.data(), result.size());
-}
-
-std::vector<uint8_t> PN532_BLE::hf15Rdbl(uint8_t block)
-{
-    std::vector<uint8_t> readBlockCommands = {0x01, 0x20, block};
-    bool res = writeCommand(InDataExchange, readBlockCommands);
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-bool PN532_BLE::hf15Wrbl(uint8_t block, std::vector<uint8_t> data)
-{
-    std::vector<uint8_t> writeBlockCommands = {0x01, 0x21, block};
-    writeBlockCommands.insert(writeBlockCommands.end(), data.begin(), data.end());
-    bool res = writeCommand(InDataExchange, writeBlockCommands);
-    return res && cmdResponse.dataSize >= 1 && cmdResponse.data[0] == 0x00;
-}
-
-PN532_BLE::LfTagInfo PN532_BLE::lfScan()
-{
-    bool res = writeCommand(InListPassiveTarget, {0x01, 0x06});
-    if (!res)
+    for (auto &characteristic : characteristics)
     {
-        return PN532_BLE::LfTagInfo();
+        if (characteristic->canNotify())
+        {
+            chrNotify = characteristic;
+            break;
+        }
     }
-    u_int8_t *data = cmdResponse.data;
-    u_int8_t dataSize = cmdResponse.dataSize;
-    return parseLfScan(data, dataSize);
-}
-
-PN532_BLE::LfTagInfo PN532_BLE::parseLfScan(uint8_t *data, uint8_t dataSize)
-{
-    LfTagInfo tagInfo;
-    size_t offset = 0;
 
-    while (offset < dataSize)
+    if (!chrWrite)
     {
-        uint8_t tagType = data[offset];
-        offset += 1;
-        uint8_t tagNum = data[offset];
-        offset += 1;
-        std::vector<uint8_t> uid(data + offset, data + offset + 5);
-        offset += 5;
-
-        tagInfo.uid = uid;
-        tagInfo.id_dec = (uid[0] << 24) | (uid[1] << 16) | (uid[2] << 8) | uid[3];
-        tagInfo.uid_hex = bytes2HexString(&uid, 5);
+        PN532_LOGE("Write characteristic does not exist");
+        return false;
     }
 
-    return tagInfo;
-}
-
-std::vector<uint8_t> PN532_BLE::getData()
-{
-    bool res = writeCommand(TgGetData);
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-std::vector<uint8_t> PN532_BLE::setData(const std::vector<uint8_t> &data)
-{
-    bool res = writeCommand(TgSetData, data);
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-bool PN532_BLE::inRelease() { return writeCommand(InRelease, {0x00}); }
-
-std::vector<uint8_t> PN532_BLE::tgInitAsTarget(const std::vector<uint8_t> &data)
-{
-    bool res = writeCommand(TgInitAsTarget, data);
-    return std::vector<uint8_t>(cmdResponse.data, cmdResponse.data + cmdResponse.dataSize);
-}
-
-uint8_t PN532_BLE::dcs(uint8_t *data, size_t length)
-{
-    uint8_t checksum = 0;
-    for (size_t i = 0; i < length; i++)
+    if (!chrNotify)
     {
-        checksum += data[i];
+        PN532_LOGE("Notify characteristic does not exist");
+        return false;
     }
-    return (0x00 - checksum) & 0xFF;
+    return true;
 }
 
-void PN532_BLE::appendCrcA(std::vector<uint8_t> &data)
+void PN532_BLE::rememberLink(NimBLEClient *pClient)
 {
-    uint16_t crc = 0x6363; // Initial value for CRC-A
+    PN532_LinkRecord link = {};
+    NimBLEAddress address = pClient->getPeerAddress();
+    memcpy(link.address, address.getVal(), sizeof(link.address));
+    link.addressType = address.getType();
+    fromUuid(pSvc->getUUID(), link.service);
+    fromUuid(chrWrite->getUUID(), link.write);
+    fromUuid(chrNotify->getUUID(), link.notify);
+    link.serviceHandle = pSvc->getStartHandle();
+    link.writeHandle = chrWrite->getHandle();
+    link.notifyHandle = chrNotify->getHandle();
+    strncpy(link.name, getName().c_str(), sizeof(link.name) - 1);
 
-    for (size_t i = 0; i < data.size(); i++)
+    // Only written when it changed, flash wears with every write
+    bool changed = !_linkKnown || memcmp(&link, &_link, sizeof(link)) != 0;
+    _link = link;
+    _linkKnown = true;
+    if (changed && _store && !_store->save(_link))
     {
-        uint8_t ch = data[i] ^ (crc & 0xFF);
-        ch = (ch ^ (ch << 4)) & 0xFF;
-        crc = (crc >> 8) ^ (ch << 8) ^ (ch << 3) ^ (ch >> 4);
+        PN532_LOGW("Failed to save the link");
     }
-
-    crc &= 0xFFFF;
-    data.push_back(crc & 0xFF);
-    data.push_back(crc >> 8);
 }
 
-void PN532_BLE::appendCrc16Ccitt(std::vector<uint8_t> &data)
+void PN532_BLE::setDevice(NimBLEAdvertisedDevice device)
 {
-    uint16_t crc = 0xFFFF;
-    for (size_t i = 0; i < data.size(); i++)
-    {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++)
-        {
-            if (crc & 1)
-            {
-                crc = (crc >> 1) ^ 0x8408;
-            }
-            else
-            {
-                crc >>= 1;
-            }
-        }
-    }
-    crc ^= 0xFFFF;
-    data.push_back(crc & 0xFF);
-    data.push_back((crc >> 8) & 0xFF);
+    _device = device;
+    _name.clear();
 }
 
-String PN532_BLE::bytes2HexString(std::vector<uint8_t> *data, uint8_t dataSize)
+void PN532_BLE::NotifyCallBack(
+    NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify)
 {
-    String hexString = "";
-    for (size_t i = 0; i < dataSize; i++)
-    {
-        hexString += (*data)[i] < 0x10 ? "0" : "";
-        hexString += String((*data)[i], HEX);
-    }
-    hexString.toUpperCase();
-    return hexString;
+    // The reader only answers what it received
+    _credits = _tuning.credits;
+    _creditSignal.notify();
+    receive(pData, length);
 }
-
-std::vector<uint8_t> PN532_BLE::hexStringToUint8Array(const std::string &hexString)
-{
-    std::vector<uint8_t> result;
-    if (hexString.length() % 2 != 0)
-    {
-        std::string paddedHexString = "0" + hexString;
-        return hexStringToUint8Array(paddedHexString);
-    }
-
-    for (size_t i = 0; i < hexString.length(); i += 2)
-    {
-        std::string byteString = hexString.substr(i, 2);
-        uint8_t byte = static_cast<uint8_t>(std::stoul(byteString, nullptr, 16));
-        result.push_back(byte);
-    }
-
-    return result;
-}
\ No newline at end of file
@@ -9,189 +9,155 @@
  #ifndef PN532_BLE_H
  #define PN532_BLE_H
  
+ #include "pn532.h"
+ #include "pn532_link_store.h"
+ #if defined(ESP_PLATFORM)
+ #include <esp_timer.h>
+ #endif
  #include <NimBLEDevice.h>
  #include <array>
+ #include <atomic>
+ #include <memory>
  #include <vector>
  
- class PN532_BLE {
+ // NimBLE transport for PN532 BLE readers. The command layer lives in PN532.
+ class PN532_BLE : public PN532, public PN532_Transport {
  public:
-     uint8_t DATA_PREAMBLE = 0x00;
-     std::array<uint8_t, 2> DATA_START_CODE = {0x00, 0xFF};
-     uint8_t DATA_TIF_SEND = 0xD4;
-     uint8_t DATA_TIF_RECEIVE = 0xD5;
-     uint8_t DATA_POSTAMBLE = 0x00;
- 
-     enum Command {
-         Diagnose = 0x00,
-         GetFirmwareVersion = 0x02,
-         ReadRegister = 0x06,
-         WriteRegister = 0x08,
-         SAMConfiguration = 0x14,
-         PowerDown = 0x16,
-         InDataExchange = 0x40,
-         InCommunicateThru = 0x42,
-         InListPassiveTarget = 0x4A,
-         InDeselect = 0x44,
-         InRelease = 0x52,
-         InSelect = 0x54,
-         InAutoPoll = 0x60,
-         TgInitAsTarget = 0x8C,
-         TgGetData = 0x86,
-         TgSetData = 0x8E
-     };
- 
-     enum RspStatus {
-         HF_TAG_OK = 0x00,     // IC card operation is successful
-         HF_TAG_NO = 0x01,     // IC card not found
-         HF_ERR_STAT = 0x02,   // Abnormal IC card communication
-         HF_ERR_CRC = 0x03,    // IC card communication verification abnormal
-         HF_COLLISION = 0x04,  // IC card conflict
-         HF_ERR_BCC = 0x05,    // IC card BCC error
-         MF_ERR_AUTH = 0x06,   // MF card verification failed
-         HF_ERR_PARITY = 0x07, // IC card parity error
-         HF_ERR_ATS = 0x08,    // ATS should be present but card NAKed, or ATS too large
- 
-         // Some operations with low frequency cards succeeded!
-         LF_TAG_OK = 0x40,
-         // Unable to search for a valid EM410X label
-         EM410X_TAG_NO_FOUND = 0x41,
- 
-         // The parameters passed by the BLE instruction are wrong,
-         // or the parameters passed by calling some functions are wrong
-         PAR_ERR = 0x60,
-         // The mode of the current device is wrong, and the corresponding
-         // API cannot be called
-         DEVICE_MODE_ERROR = 0x66,
-         INVALID_CMD = 0x67,
-         SUCCESS = 0x68,
-         NOT_IMPLEMENTED = 0x69,
-         FLASH_WRITE_FAIL = 0x70,
-         FLASH_READ_FAIL = 0x71,
-         INVALID_SLOT_TYPE = 0x72,
-     };
- 
      PN532_BLE(bool debug = false);
      ~PN532_BLE();
  
+     // Every criterion that is set has to match
+     typedef struct {
+         std::string namePattern = readerNamePattern(); // '*' any run, '?' any character, empty: any name
+         bool requireService = false; // advertises FFF0 or FFE0, not every reader puts it in the advertisement
+         int8_t minRssi = -127;
+         uint32_t timeoutMs = 5000;
+     } DiscoveryFilter;
+     // Applied on the next connection. Intervals are in 1.25 ms units, the
+     // supervision timeout in 10 ms units.
+     typedef struct {
+         uint16_t mtu = 247; // asked for on connect, a write then carries 244 bytes
+         uint16_t dataLength = 251; // link layer payload, so one write fits one packet
+         // While commands are going out
+         uint16_t fastMinInterval = 6;
+         uint16_t fastMaxInterval = 12;
+         // After idleAfterMs without a command, to save power; 0 stays fast
+         uint16_t idleMinInterval = 80;
+         uint16_t idleMaxInterval = 160;
+         uint16_t idleLatency = 0;
+         uint16_t supervisionTimeout = 400;
+         uint32_t idleAfterMs = 2000;
+         // Used when the characteristic supports it. After credits writes
+         // without response one write waits for the reader again, as does
+         // every reply. A characteristic that only takes writes without
+         // response waits for a reply or two connection intervals instead.
+         bool writeWithoutResponse = true;
+         uint8_t credits = 4;
+     } LinkTuning;
+     typedef struct {
+         uint16_t mtu;
+         float intervalMs;
+         uint16_t latency;
+         uint16_t supervisionTimeoutMs;
+         bool writeWithoutResponse;
+         bool fast; // fast parameters are requested, the reader may have refused them
+     } LinkInfo;
+
+     // Runs on the NimBLE host task, with the first match or with nullptr
+     // when the scan ended without one
+     typedef std::function<void(const NimBLEAdvertisedDevice *device)> DiscoveryCallback;
+
+     // Starts a scan and returns at once; the scan stops at the first match
+     bool startDiscovery(const DiscoveryFilter &filter, DiscoveryCallback callback);
+     // Blocks until the first match, which connectToDevice() then uses.
+     // Returns false if none was seen within filter.timeoutMs.
+     bool discover(const DiscoveryFilter &filter);
+     // discover() with the default filter
      bool searchForDevice();
      bool connectToDevice();
-     void writeData(const std::vector<uint8_t> &data);
+     // Connects to a reader whose address is known, e.g. getAddress() of an
+     // earlier session, without scanning. The address type has to match.
+     bool connectToAddress(const NimBLEAddress &address, uint32_t timeoutMs = 3000);
+     NimBLEAddress getAddress();
+     // Keeps the address and GATT handles of the connected reader, e.g. in a
+     // PN532_NvsLinkStore so reconnect() still works after a reboot
+     void setLinkStore(PN532_LinkStore *store) { _store = store; }
+     // Connects to the reader of the last connection, or the one in the link
+     // store, without scanning. Only the cached service and characteristics
+     // are looked up; when their handles changed, e.g. after a firmware
+     // update of the reader, it falls back to full discovery.
+     bool reconnect(uint32_t timeoutMs = 3000);
+     // On by default: a dropped link is restored by the next command, and
+     // the commands on the air when it dropped are sent again
+     void setAutoReconnect(bool enabled) { _autoReconnect = enabled; }
+     void setLinkTuning(const LinkTuning &tuning);
+     // What was negotiated with the connected reader
+     LinkInfo getLinkInfo();
      void setDevice(NimBLEAdvertisedDevice device);
-     bool isConnected();
+     bool isConnected() override;
+     bool write(const uint8_t *data, size_t length) override;
+     bool restoreLink() override;
      bool isPN532Killer();
      NimBLEAdvertisedDevice _device;
-     std::string getName() { return _device.getName(); }
- 
-     void wakeup();
-     bool halt();
-     bool setNormalMode();
-     bool getVersion();
- 
-     typedef struct {
-         uint8_t raw[250];
-         size_t length;
-         uint16_t command;
-         uint8_t status;
-         uint8_t dataSize;
-         uint8_t data[200];
-     } CmdResponse;
- 
-     CmdResponse cmdResponse;
-     std::vector<PN532_BLE::CmdResponse> pn532Responses;
-     std::vector<uint8_t> pn532bleBuffer;
- 
-     typedef struct {
-         std::vector<uint8_t> atqa;
-         uint8_t sak;
-         uint8_t uidSize;
-         std::vector<uint8_t> uid;
-         String uid_hex;
-         String sak_hex;
-         String atqa_hex;
-         String type;
-     } Iso14aTagInfo;
-     Iso14aTagInfo hf14aTagInfo;
-     Iso14aTagInfo hf14aScan();
-     bool mfAuth(std::vector<uint8_t> uid, uint8_t block, uint8_t *key, bool useKeyA);
-     std::vector<uint8_t> mfRdbl(uint8_t block);
-     bool mfWrbl(uint8_t block, std::vector<uint8_t> data);
-     bool mfuWrbl(uint8_t block, std::vector<uint8_t> data);
-     std::vector<uint8_t> sendData(std::vector<uint8_t> data, bool append_crc);
-     std::vector<uint8_t> send7bit(std::vector<uint8_t> data);
-     bool isGen1A();
-     bool selectTag();
-     bool isGen3();
-     bool isGen4(std::string pwd);
- 
-     typedef struct {
-         std::vector<uint8_t> uid;
-         String uid_hex;
-         uint8_t dsfid;
-         uint8_t afi;
-         uint8_t icRef;
-         uint8_t blockSize;
-     } Iso15TagInfo;
-     Iso15TagInfo hf15TagInfo;
-     std::vector<uint8_t> sendHf15Data(std::vector<uint8_t> data, bool append_crc, bool no_check_response);
-     Iso15TagInfo hf15Scan();
-     Iso15TagInfo hf15Info();
-     std::vector<uint8_t> hf15Rdbl(uint8_t block);
-     bool hf15Wrbl(uint8_t block, std::vector<uint8_t> data);
- 
-     std::vector<uint8_t> getData();
-     std::vector<uint8_t> setData(const std::vector<uint8_t> &data);
-     bool inRelease();
-     std::vector<uint8_t> tgInitAsTarget(const std::vector<uint8_t> &data);
- 
-     typedef struct {
-         std::vector<uint8_t> uid;
-         String uid_hex;
-         int id_dec;
-     } LfTagInfo;
-     LfTagInfo lfTagInfo;
- 
-     LfTagInfo lfScan();
- 
-     uint8_t mifareDefaultKey[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-     uint8_t mifareKey[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+     std::string getName() { return _name.empty() ? _device.getName() : _name; }
+
+     // Advertised names of supported readers match "*PN532*BLE*"
+     static const char *readerNamePattern() { return "*PN532*BLE*"; }
+     static bool isReaderName(const std::string &name);
+     static bool matchName(const std::string &pattern, const std::string &name);
+     // The NimBLE stack is shared by every reader and PN532_BLEManager. The
+     // first holder starts it, the last one to release it shuts it down,
+     // unless the application had started it already.
+     static void acquireStack();
+     static void releaseStack();
  
  private:
      std::vector<NimBLEUUID> serviceUUIDs = {NimBLEUUID("FFF0"), NimBLEUUID("FFE0")};
      NimBLERemoteService *getService(NimBLEClient *pClient);
- 
+     NimBLEClient *createClient();
+     bool attach(NimBLEClient *pClient);
+     bool attachCached(NimBLEClient *pClient);
+     bool discoverLink(NimBLEClient *pClient);
+     void rememberLink(NimBLEClient *pClient);
+     bool isLinkAddress(const NimBLEAddress &address);
+     void tuneLink();
+     void busy();
+     void requestParams(bool fast);
+     bool writeChunk(const uint8_t *data, size_t length);
+     uint32_t creditWaitMs();
+     static void onIdle(void *arg);
+     void holdStack();
+ 
+     class DiscoveryCallbacks;
+     class LinkCallbacks;
+
+     NimBLEClient *_client = nullptr;
+     std::unique_ptr<LinkCallbacks> _linkCallbacks;
+     PN532_LinkStore *_store = nullptr;
+     PN532_LinkRecord _link = {}; // of the last connection, or loaded from _store
+     bool _linkKnown = false;
+     bool _autoReconnect = true;
+     LinkTuning _tuning;
+     bool _noResponse = false;
+     bool _withResponse = true;
+     PN532_Signal _creditSignal;
+     std::atomic<uint8_t> _credits{0};
+     std::atomic<bool> _fast{false};
+ #if defined(ESP_PLATFORM)
+     esp_timer_handle_t _idleTimer = nullptr;
+ #endif
+     bool _stackHeld = false;
+     std::string _name; // read from the reader when connected by address
+     std::unique_ptr<DiscoveryCallbacks> _discovery;
+     PN532_Signal _discoverySignal;
+     bool _discovered = false;
      NimBLERemoteService *pSvc = nullptr;
      NimBLERemoteCharacteristic *chrWrite = nullptr;
      NimBLERemoteCharacteristic *chrNotify = nullptr;
  
-     bool _debug = false;
- 
-     bool writeCommand(Command cmd, uint8_t *data = nullptr, size_t length = 0);
-     bool writeCommand(Command cmd, const std::vector<uint8_t> &data);
-     bool checkResponse(uint8_t cmd);
-     bool isCompleteFrame(uint8_t *pData, size_t length);
- 
-     bool resetRegister();
- 
-     Iso14aTagInfo parseHf14aScan(uint8_t *data, uint8_t dataSize);
-     String getTagType();
-     String getHf14aTagType();
-     Iso15TagInfo parseHf15Scan(uint8_t *data, uint8_t dataSize);
-     Iso15TagInfo parseHf15TagInfo(uint8_t *data, uint8_t dataSize);
-     String getHf15TagType();
-     LfTagInfo parseLfScan(uint8_t *data, uint8_t dataSize);
- 
-     uint8_t dcs(uint8_t *data, size_t length);
-     void appendCrcA(std::vector<uint8_t> &data);
-     void appendCrc16Ccitt(std::vector<uint8_t> &data);
-     String bytes2HexString(std::vector<uint8_t> *data, uint8_t dataSize);
-     std::vector<uint8_t> hexStringToUint8Array(const std::string &hexString);
      void NotifyCallBack(
          NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify
      );
-     void handleNotifyCallBack(
-         NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify
-     );
  };
  
- #endif // PN532_BLE_H
- 
\ No newline at end of file
+ #endif // PN532_BLE_H
\ No newline at end of file
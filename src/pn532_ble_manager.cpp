@@ -0,0 +1,116 @@
+/**
+ * @file pn532_ble_manager.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Discovers, connects and drives several PN532 BLE readers at once
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_ble_manager.h"
+
+namespace
+{
+    // Stops the scan once the wanted number of new readers answered
+    class readerScanCallbacks : public NimBLEScanCallbacks
+    {
+    public:
+        typedef std::function<bool(const NimBLEAddress &address)> Filter;
+
+        readerScanCallbacks(size_t wanted, Filter isKnown) : _wanted(wanted), _isKnown(isKnown) {}
+
+        void onResult(const NimBLEAdvertisedDevice *advertisedDevice)
+        {
+            if (PN532_BLE::isReaderName(advertisedDevice->getName()) && !_isKnown(advertisedDevice->getAddress()) &&
+                ++_seen >= _wanted)
+            {
+                NimBLEDevice::getScan()->stop();
+            }
+        }
+
+    private:
+        size_t _wanted;
+        size_t _seen = 0;
+        Filter _isKnown;
+    };
+}
+
+PN532_BLEManager::~PN532_BLEManager()
+{
+    for (size_t i = 0; i < _count; i++)
+    {
+        _group.remove(*_readers[i]);
+        _readers[i].reset();
+    }
+    if (_stackHeld)
+    {
+        PN532_BLE::releaseStack();
+    }
+}
+
+bool PN532_BLEManager::isKnown(const NimBLEAddress &address)
+{
+    for (size_t i = 0; i < _count; i++)
+    {
+        if (_readers[i]->_device.getAddress() == address)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t PN532_BLEManager::scan(uint32_t durationMs, size_t maxReaders)
+{
+    if (!_stackHeld)
+    {
+        PN532_BLE::acquireStack();
+        _stackHeld = true;
+    }
+    size_t wanted = std::min(maxReaders, MAX_READERS - _count);
+    if (wanted == 0)
+    {
+        return 0;
+    }
+
+    readerScanCallbacks callbacks(wanted, [this](const NimBLEAddress &address) { return isKnown(address); });
+    NimBLEScan *pScan = NimBLEDevice::getScan();
+    pScan->setScanCallbacks(&callbacks, false);
+    pScan->setActiveScan(true);
+    NimBLEScanResults foundDevices = pScan->getResults(durationMs, false);
+    pScan->setScanCallbacks(nullptr, false);
+
+    size_t added = 0;
+    for (int i = 0; i < foundDevices.getCount() && _count < MAX_READERS; i++)
+    {
+        const NimBLEAdvertisedDevice *advertisedDevice = foundDevices.getDevice(i);
+        if (!PN532_BLE::isReaderName(advertisedDevice->getName()) || isKnown(advertisedDevice->getAddress()))
+        {
+            continue;
+        }
+        _readers[_count].reset(new PN532_BLE(_debug));
+        _readers[_count]->setDevice(*advertisedDevice);
+        _group.add(*_readers[_count]);
+        _count++;
+        added++;
+        if (_debug)
+            PN532_LOGD("Reader %u: %s", (unsigned)_count, advertisedDevice->getName().c_str());
+    }
+    pScan->clearResults();
+    return added;
+}
+
+size_t PN532_BLEManager::connectAll()
+{
+    size_t connected = 0;
+    for (size_t i = 0; i < _count; i++)
+    {
+        PN532_BLE &reader = *_readers[i];
+        if (!reader.isConnected() && !reader.connectToDevice())
+        {
+            PN532_LOGW("Reader %s did not connect", reader.getName().c_str());
+            continue;
+        }
+        connected++;
+    }
+    return connected;
+}
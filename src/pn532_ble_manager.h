@@ -0,0 +1,62 @@
+/**
+ * @file pn532_ble_manager.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Discovers, connects and drives several PN532 BLE readers at once
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_BLE_MANAGER_H
+ #define PN532_BLE_MANAGER_H
+
+ #include "pn532_ble.h"
+ #include "pn532_group.h"
+ #include <memory>
+
+ // Holds the NimBLE stack for as long as it lives and owns one PN532_BLE per
+ // reader, each with its own connection, parser and request queue. Commands
+ // go through group(), which keeps every reader busy from one task:
+ //     PN532_BLEManager manager;
+ //     manager.scan(5000);
+ //     manager.connectAll();
+ //     for (size_t i = 0; i < manager.readerCount(); i++)
+ //         manager.group().submit(i, PN532::InListPassiveTarget, {0x01, 0x00}, onScan);
+ //     manager.group().flush(1000);
+ // The blocking API of reader(i) still works, but only from the task that
+ // runs group().process().
+ class PN532_BLEManager {
+ public:
+ #if defined(CONFIG_BT_NIMBLE_MAX_CONNECTIONS)
+     static const size_t MAX_READERS = CONFIG_BT_NIMBLE_MAX_CONNECTIONS < PN532_ReaderGroup::MAX_READERS
+                                           ? CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+                                           : PN532_ReaderGroup::MAX_READERS;
+ #else
+     static const size_t MAX_READERS = 3;
+ #endif
+
+     PN532_BLEManager(bool debug = false) : _debug(debug) {}
+     // Disconnects every reader, then lets go of the stack
+     ~PN532_BLEManager();
+
+     // Scans for up to durationMs, stopping as soon as maxReaders readers not
+     // seen before answered. Returns the number of readers added.
+     size_t scan(uint32_t durationMs = 5000, size_t maxReaders = MAX_READERS);
+     // Connects every reader that is not connected yet. Returns how many are
+     // connected. Reader i is group()[i], connected or not.
+     size_t connectAll();
+
+     size_t readerCount() const { return _count; }
+     PN532_BLE &reader(size_t index) { return *_readers[index]; }
+     PN532_ReaderGroup &group() { return _group; }
+
+ private:
+     std::unique_ptr<PN532_BLE> _readers[MAX_READERS];
+     size_t _count = 0;
+     PN532_ReaderGroup _group;
+     bool _stackHeld = false;
+     bool _debug;
+
+     bool isKnown(const NimBLEAddress &address);
+ };
+
+ #endif // PN532_BLE_MANAGER_H
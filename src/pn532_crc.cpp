@@ -0,0 +1,66 @@
+/**
+ * @file pn532_crc.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Table driven CRC_A and ISO/IEC 15693 CRC
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_crc.h"
+
+namespace
+{
+    const uint16_t POLYNOMIAL = 0x8408;
+
+    constexpr uint16_t shift(uint16_t crc, int bits)
+    {
+        return bits == 0 ? crc : shift((crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1, bits - 1);
+    }
+
+    // CRC of byte i followed by n zero bytes, starting from 0: table n of the
+    // slicing-by-4 set
+    constexpr uint16_t entry(uint16_t i, int n)
+    {
+        return n == 0 ? shift(i, 8) : (entry(i, n - 1) >> 8) ^ shift(entry(i, n - 1) & 0xFF, 8);
+    }
+
+    struct Tables {
+        uint16_t t[4][256];
+    };
+
+    // Index sequence, C++11 has none
+    template <uint16_t... I> struct Indices {};
+    template <uint16_t N, uint16_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template <uint16_t... I> struct MakeIndices<0, I...> {
+        typedef Indices<I...> type;
+    };
+
+    template <uint16_t... I> constexpr Tables makeTables(Indices<I...>)
+    {
+        return {{{entry(I, 0)...}, {entry(I, 1)...}, {entry(I, 2)...}, {entry(I, 3)...}}};
+    }
+
+    constexpr Tables TABLES = makeTables(MakeIndices<256>::type());
+    static_assert(TABLES.t[0][1] == 0x1189 && TABLES.t[0][128] == 0x8408, "CRC table");
+}
+
+uint16_t PN532_Crc::update(uint16_t crc, const uint8_t *data, size_t length)
+{
+    const uint16_t(*t)[256] = TABLES.t;
+    // Short frames are most of the traffic, slicing only pays off from a block up
+    if (length >= 16)
+    {
+        while (length >= 4)
+        {
+            crc ^= data[0] | (data[1] << 8);
+            crc = t[3][crc & 0xFF] ^ t[2][crc >> 8] ^ t[1][data[2]] ^ t[0][data[3]];
+            data += 4;
+            length -= 4;
+        }
+    }
+    while (length--)
+    {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file pn532_crc.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Table driven CRC_A and ISO/IEC 15693 CRC
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_CRC_H
+ #define PN532_CRC_H
+
+ #include <stddef.h>
+ #include <stdint.h>
+
+ // Both card types use CRC-16/CCITT bit reversed (polynomial 0x8408), only the
+ // preset and the final inversion differ, so they share one set of tables
+ // generated at compile time. Inputs of 16 bytes or more run slicing-by-4.
+ //
+ // update() carries the running value across calls, so a frame that arrives
+ // in pieces can be checked piece by piece:
+ //     uint16_t crc = PN532_Crc::CRC_A_PRESET;
+ //     crc = PN532_Crc::update(crc, first, firstLength);
+ //     crc = PN532_Crc::update(crc, rest, restLength);
+ // Over data followed by its own CRC the result is the residue, see verify*.
+ class PN532_Crc {
+ public:
+     // ISO/IEC 14443-3 CRC_A, sent LSB first, not inverted
+     static const uint16_t CRC_A_PRESET = 0x6363;
+     static const uint16_t CRC_A_RESIDUE = 0x0000;
+     // ISO/IEC 15693 CRC, sent LSB first, inverted
+     static const uint16_t CRC_15693_PRESET = 0xFFFF;
+     static const uint16_t CRC_15693_RESIDUE = 0xF0B8;
+
+     static uint16_t update(uint16_t crc, const uint8_t *data, size_t length);
+
+     static uint16_t crcA(const uint8_t *data, size_t length) { return update(CRC_A_PRESET, data, length); }
+     static uint16_t crc15693(const uint8_t *data, size_t length)
+     {
+         return ~update(CRC_15693_PRESET, data, length) & 0xFFFF;
+     }
+
+     // Writes the CRC of the first length bytes to out[length] and out[length + 1]
+     static void appendCrcA(uint8_t *data, size_t length) { store(data + length, crcA(data, length)); }
+     static void append15693(uint8_t *data, size_t length) { store(data + length, crc15693(data, length)); }
+
+     // True if the last two bytes are the CRC of the ones before them
+     static bool verifyA(const uint8_t *data, size_t length)
+     {
+         return length > 2 && update(CRC_A_PRESET, data, length) == CRC_A_RESIDUE;
+     }
+     static bool verify15693(const uint8_t *data, size_t length)
+     {
+         return length > 2 && update(CRC_15693_PRESET, data, length) == CRC_15693_RESIDUE;
+     }
+
+ private:
+     static void store(uint8_t *out, uint16_t crc)
+     {
+         out[0] = crc & 0xFF;
+         out[1] = crc >> 8;
+     }
+ };
+
+ #endif // PN532_CRC_H
@@ -0,0 +1,146 @@
+/**
+ * @file pn532_frame.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief PN532 information frame encoding
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_frame.h"
+
+size_t PN532_FrameEncoder::encode(
+    uint8_t *out, size_t capacity, uint8_t tfi, uint8_t command, const uint8_t *data, size_t length)
+{
+    size_t frameSize = length + (length <= MAX_NORMAL_PAYLOAD ? 9 : 12);
+    if (length > MAX_PAYLOAD || capacity < frameSize || (data == nullptr && length > 0))
+    {
+        return 0;
+    }
+
+    size_t len = length + 2;
+    uint8_t *p = out;
+    *p++ = 0x00; // preamble
+    *p++ = 0x00; // start code
+    *p++ = 0xFF;
+    if (length <= MAX_NORMAL_PAYLOAD)
+    {
+        *p++ = len;
+        *p++ = (0x00 - len) & 0xFF;
+    }
+    else
+    {
+        // FF FF marks an extended frame, the length follows MSB first
+        *p++ = 0xFF;
+        *p++ = 0xFF;
+        *p++ = len >> 8;
+        *p++ = len & 0xFF;
+        *p++ = (0x00 - (len >> 8) - len) & 0xFF;
+    }
+    *p++ = tfi;
+    *p++ = command;
+
+    uint8_t sum = tfi + command;
+    for (size_t i = 0; i < length; i++)
+    {
+        p[i] = data[i];
+        sum += data[i];
+    }
+    p += length;
+    *p++ = (0x00 - sum) & 0xFF;
+    *p++ = 0x00; // postamble
+    return p - out;
+}
+
+PN532_FrameParser::Event PN532_FrameParser::feed(uint8_t b)
+{
+    switch (_state)
+    {
+    case StateStart0:
+        if (b == 0x00)
+        {
+            _state = StateStart1;
+        }
+        return EventNone;
+
+    case StateStart1:
+        // The preamble is optional, so both 00 FF and 00 00 FF start a frame
+        if (b == 0xFF)
+        {
+            _state = StateLen;
+        }
+        else if (b != 0x00)
+        {
+            _state = StateStart0;
+        }
+        return EventNone;
+
+    case StateLen:
+        _len = b;
+        _state = StateLcs;
+        return EventNone;
+
+    case StateLcs:
+        _state = StateStart0;
+        if (_len == 0x00 && b == 0xFF)
+        {
+            return EventAck;
+        }
+        if (_len == 0xFF && b == 0x00)
+        {
+            return EventNack;
+        }
+        if (_len == 0xFF && b == 0xFF)
+        {
+            _state = StateExtLenHigh;
+            return EventNone;
+        }
+        if (((_len + b) & 0xFF) != 0x00 || _len == 0x00)
+        {
+            _state = b == 0x00 ? StateStart1 : StateStart0;
+            return EventChecksumError;
+        }
+        _length = 0;
+        _sum = 0;
+        _state = StateBody;
+        return EventNone;
+
+    case StateExtLenHigh:
+        _len = b << 8;
+        _state = StateExtLenLow;
+        return EventNone;
+
+    case StateExtLenLow:
+        _len |= b;
+        _state = StateExtLcs;
+        return EventNone;
+
+    case StateExtLcs:
+        if ((((_len >> 8) + _len + b) & 0xFF) != 0x00 || _len == 0x00 || _len > sizeof(_frame))
+        {
+            _state = b == 0x00 ? StateStart1 : StateStart0;
+            return EventChecksumError;
+        }
+        _length = 0;
+        _sum = 0;
+        _state = StateBody;
+        return EventNone;
+
+    case StateBody:
+        _frame[_length++] = b;
+        _sum += b;
+        if (_length == _len)
+        {
+            _state = StateDcs;
+        }
+        return EventNone;
+
+    case StateDcs:
+        _state = StateStart0;
+        if (((_sum + b) & 0xFF) != 0x00)
+        {
+            return EventChecksumError;
+        }
+        return _frame[0] == 0x7F ? EventError : EventFrame;
+    }
+    return EventNone;
+}
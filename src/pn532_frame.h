@@ -0,0 +1,116 @@
+/**
+ * @file pn532_frame.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief PN532 information frame encoding
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_FRAME_H
+ #define PN532_FRAME_H
+
+ #include <array>
+ #include <stddef.h>
+ #include <stdint.h>
+
+ // Writes PREAMBLE, START CODE, LEN, LCS, TFI, CMD, payload, DCS and POSTAMBLE
+ // in a single pass into a fixed buffer. No heap is touched. Payloads that do
+ // not fit a normal frame are sent as an extended frame.
+ class PN532_FrameEncoder {
+ public:
+     // 00 00 FF LEN LCS TFI CMD PD0..PD252 DCS 00
+     static const size_t MAX_NORMAL_PAYLOAD = 253;
+     // 00 00 FF FF FF LENM LENL LCS TFI CMD PD0..PD262 DCS 00
+     static const size_t MAX_PAYLOAD = 263;
+     // Largest LEN, counting TFI and CMD
+     static const size_t MAX_FRAME_LEN = MAX_PAYLOAD + 2;
+     static const size_t MAX_FRAME_SIZE = MAX_PAYLOAD + 12;
+
+     // Returns the frame length, or 0 if the frame does not fit into capacity.
+     static size_t encode(
+         uint8_t *out, size_t capacity, uint8_t tfi, uint8_t command, const uint8_t *data, size_t length
+     );
+
+     size_t encode(uint8_t tfi, uint8_t command, const uint8_t *data, size_t length)
+     {
+         _length = encode(_buffer, sizeof(_buffer), tfi, command, data, length);
+         return _length;
+     }
+     const uint8_t *data() const { return _buffer; }
+     size_t length() const { return _length; }
+
+ private:
+     uint8_t _buffer[MAX_FRAME_SIZE];
+     size_t _length = 0;
+ };
+
+ // Sum of bytes for the checksums, C++11 constexpr has no loops
+ constexpr uint8_t pn532ByteSum() { return 0; }
+ template <typename... Rest> constexpr uint8_t pn532ByteSum(uint8_t first, Rest... rest)
+ {
+     return (first + pn532ByteSum(rest...)) & 0xFF;
+ }
+
+ // Host to PN532 frame with a payload known at compile time. The wire bytes
+ // are a constant in flash, LEN, LCS and DCS included, so sending one costs
+ // no encoding and no copy:
+ //     typedef PN532_StaticFrame<0x4A, 0x01, 0x00> ListIso14a;
+ //     transport->write(ListIso14a::bytes.data(), ListIso14a::bytes.size());
+ template <uint8_t Command, uint8_t... Payload> struct PN532_StaticFrame {
+     static_assert(sizeof...(Payload) <= PN532_FrameEncoder::MAX_NORMAL_PAYLOAD, "payload needs an extended frame");
+
+     static const uint8_t TFI = 0xD4;
+     static const uint8_t COMMAND = Command;
+     static const uint8_t LEN = sizeof...(Payload) + 2;
+     static constexpr std::array<uint8_t, sizeof...(Payload) + 9> bytes = {{
+         0x00, 0x00, 0xFF, LEN, (uint8_t)(0x00 - LEN), TFI, Command, Payload...,
+         (uint8_t)(0x00 - pn532ByteSum(TFI, Command, Payload...)), 0x00,
+     }};
+ };
+
+ template <uint8_t Command, uint8_t... Payload>
+ constexpr std::array<uint8_t, sizeof...(Payload) + 9> PN532_StaticFrame<Command, Payload...>::bytes;
+
+ // Byte-at-a-time receive state machine. Each byte costs O(1), frames may be
+ // split across or packed into notifications arbitrarily, and anything that
+ // is not a valid frame is skipped until the next start code. Normal and
+ // extended frames are both accepted.
+ class PN532_FrameParser {
+ public:
+     enum Event {
+         EventNone,
+         EventAck,           // 00 00 FF 00 FF 00
+         EventNack,          // 00 00 FF FF 00 00
+         EventError,         // application level error frame, TFI 0x7F
+         EventFrame,         // normal or extended information frame, see frame()/frameLength()
+         EventChecksumError, // LCS or DCS mismatch or LEN too large, the frame was dropped
+     };
+
+     Event feed(uint8_t b);
+     void reset() { _state = StateStart0; }
+
+     // TFI, command code and payload of the last EventFrame/EventError
+     const uint8_t *frame() const { return _frame; }
+     size_t frameLength() const { return _length; }
+
+ private:
+     enum State {
+         StateStart0,
+         StateStart1,
+         StateLen,
+         StateLcs,
+         StateExtLenHigh,
+         StateExtLenLow,
+         StateExtLcs,
+         StateBody,
+         StateDcs,
+     };
+
+     State _state = StateStart0;
+     uint16_t _len = 0;
+     uint8_t _sum = 0;
+     size_t _length = 0;
+     uint8_t _frame[PN532_FrameEncoder::MAX_FRAME_LEN];
+ };
+
+ #endif // PN532_FRAME_H
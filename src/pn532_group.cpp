@@ -0,0 +1,127 @@
+/**
+ * @file pn532_group.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Drives the asynchronous queues of several readers from one task
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_group.h"
+#include <algorithm>
+
+namespace
+{
+    // Longest sleep between two passes, so request timeouts are noticed
+    const uint32_t WAIT_SLICE_MS = 10;
+}
+
+PN532_ReaderGroup::~PN532_ReaderGroup()
+{
+    for (size_t i = 0; i < _count; i++)
+    {
+        _readers[i]->setWakeSignal(nullptr);
+    }
+}
+
+bool PN532_ReaderGroup::add(PN532 &reader)
+{
+    if (_count == MAX_READERS || std::find(_readers, _readers + _count, &reader) != _readers + _count)
+    {
+        return false;
+    }
+    _readers[_count++] = &reader;
+    reader.setWakeSignal(&_signal);
+    return true;
+}
+
+void PN532_ReaderGroup::remove(PN532 &reader)
+{
+    PN532 **end = _readers + _count;
+    PN532 **it = std::find(_readers, end, &reader);
+    if (it == end)
+    {
+        return;
+    }
+    reader.setWakeSignal(nullptr);
+    std::copy(it + 1, end, it);
+    _readers[--_count] = nullptr;
+    _next = 0;
+}
+
+PN532::CommandCallback PN532_ReaderGroup::counted(PN532::CommandCallback callback)
+{
+    return [this, callback](bool success, const PN532::CmdResponse &response)
+    {
+        _completed++;
+        if (callback)
+        {
+            callback(success, response);
+        }
+    };
+}
+
+bool PN532_ReaderGroup::submit(
+    size_t reader, PN532::Command cmd, const uint8_t *data, size_t length, PN532::CommandCallback callback,
+    uint32_t timeoutMs)
+{
+    return reader < _count && _readers[reader]->submit(cmd, data, length, counted(callback), timeoutMs);
+}
+
+bool PN532_ReaderGroup::submit(
+    size_t reader, PN532::Command cmd, std::initializer_list<uint8_t> data, PN532::CommandCallback callback,
+    uint32_t timeoutMs)
+{
+    return submit(reader, cmd, data.begin(), data.size(), callback, timeoutMs);
+}
+
+size_t PN532_ReaderGroup::pending()
+{
+    size_t pending = 0;
+    for (size_t i = 0; i < _count; i++)
+    {
+        pending += _readers[i]->pending();
+    }
+    return pending;
+}
+
+size_t PN532_ReaderGroup::process(uint32_t waitMs)
+{
+    unsigned long startTime = millis();
+    uint32_t completedBefore = _completed;
+    while (true)
+    {
+        // Each pass starts at the next reader, so none is always served last
+        size_t pending = 0;
+        for (size_t i = 0; i < _count; i++)
+        {
+            pending += _readers[(_next + i) % _count]->process(0);
+        }
+        _next = _count > 0 ? (_next + 1) % _count : 0;
+
+        if (_completed != completedBefore || pending == 0)
+        {
+            return pending;
+        }
+        unsigned long elapsed = millis() - startTime;
+        if (elapsed >= waitMs)
+        {
+            return pending;
+        }
+        _signal.wait(std::min<uint32_t>(waitMs - elapsed, WAIT_SLICE_MS));
+    }
+}
+
+bool PN532_ReaderGroup::flush(uint32_t timeoutMs)
+{
+    unsigned long startTime = millis();
+    while (pending() > 0)
+    {
+        unsigned long elapsed = millis() - startTime;
+        if (elapsed >= timeoutMs)
+        {
+            return false;
+        }
+        process(timeoutMs - elapsed);
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file pn532_group.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Drives the asynchronous queues of several readers from one task
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_GROUP_H
+ #define PN532_GROUP_H
+
+ #include "pn532.h"
+
+ // Every reader keeps its own parser, response ring and request queue, so
+ // commands to different readers are on the air at the same time and a busy
+ // reader never holds up the others. process() serves the readers round
+ // robin, starting one further each call, and sleeps on one signal all of
+ // them notify:
+ //     PN532_ReaderGroup group;
+ //     group.add(readerA);
+ //     group.add(readerB);
+ //     group.submit(0, PN532::InListPassiveTarget, {0x01, 0x00}, onScanA);
+ //     group.submit(1, PN532::InListPassiveTarget, {0x01, 0x00}, onScanB);
+ //     group.flush(1000);
+ class PN532_ReaderGroup {
+ public:
+     static const size_t MAX_READERS = 8;
+
+     ~PN532_ReaderGroup();
+
+     // Returns false when the group is full or the reader is already in it
+     bool add(PN532 &reader);
+     void remove(PN532 &reader);
+     size_t size() const { return _count; }
+     PN532 &operator[](size_t index) { return *_readers[index]; }
+
+     // Queues a command on one reader, see PN532::submit()
+     bool submit(
+         size_t reader, PN532::Command cmd, const uint8_t *data, size_t length, PN532::CommandCallback callback,
+         uint32_t timeoutMs = 0
+     );
+     bool submit(
+         size_t reader, PN532::Command cmd, std::initializer_list<uint8_t> data, PN532::CommandCallback callback,
+         uint32_t timeoutMs = 0
+     );
+
+     // Runs PN532::process() on every reader until a request completed or
+     // waitMs expired. Returns the requests still queued on all readers.
+     size_t process(uint32_t waitMs = 0);
+     // Runs process() until every reader is idle or timeoutMs expired
+     bool flush(uint32_t timeoutMs);
+     size_t pending();
+
+ private:
+     PN532 *_readers[MAX_READERS] = {};
+     size_t _count = 0;
+     size_t _next = 0;
+     uint32_t _completed = 0;
+     PN532_Signal _signal;
+
+     PN532::CommandCallback counted(PN532::CommandCallback callback);
+ };
+
+ #endif // PN532_GROUP_H
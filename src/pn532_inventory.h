@@ -0,0 +1,63 @@
+/**
+ * @file pn532_inventory.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Fixed capacity result lists for multi-target scans
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_INVENTORY_H
+ #define PN532_INVENTORY_H
+
+ #include <stddef.h>
+
+ // Inventories fill a list over storage the caller owns, nothing is
+ // allocated while scanning. Tags that find the list full are counted in
+ // overflowed(), so a caller can tell "16 tags" from "16 tags and more".
+ template <typename T> class PN532_TagList {
+ public:
+     PN532_TagList(T *tags, size_t capacity) : _tags(tags), _capacity(capacity) {}
+
+     bool add(const T &tag)
+     {
+         if (_size == _capacity)
+         {
+             _overflowed++;
+             return false;
+         }
+         _tags[_size++] = tag;
+         return true;
+     }
+     void clear()
+     {
+         _size = 0;
+         _overflowed = 0;
+     }
+
+     size_t size() const { return _size; }
+     size_t capacity() const { return _capacity; }
+     size_t overflowed() const { return _overflowed; }
+     bool empty() const { return _size == 0; }
+     const T &operator[](size_t i) const { return _tags[i]; }
+     const T *begin() const { return _tags; }
+     const T *end() const { return _tags + _size; }
+
+ private:
+     T *_tags;
+     size_t _capacity;
+     size_t _size = 0;
+     size_t _overflowed = 0;
+ };
+
+ // A list with its storage inline, e.g. PN532_Inventory<PN532::Iso15Target, 32>
+ template <typename T, size_t N> class PN532_Inventory : public PN532_TagList<T> {
+ public:
+     PN532_Inventory() : PN532_TagList<T>(_storage, N) {}
+     PN532_Inventory(const PN532_Inventory &) = delete;
+     PN532_Inventory &operator=(const PN532_Inventory &) = delete;
+
+ private:
+     T _storage[N];
+ };
+
+ #endif // PN532_INVENTORY_H
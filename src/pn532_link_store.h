@@ -0,0 +1,115 @@
+/**
+ * @file pn532_link_store.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Keeps the peer address and GATT handles of the last reader between connections
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_LINK_STORE_H
+ #define PN532_LINK_STORE_H
+
+ #include <stdint.h>
+ #if defined(ARDUINO_ARCH_ESP32)
+ #include <Preferences.h>
+ #endif
+
+ typedef struct {
+     uint8_t length; // 2, 4 or 16
+     uint8_t value[16]; // little endian, as on the air
+ } PN532_LinkUuid;
+
+ // Everything a reconnect needs to skip the scan and most of the discovery.
+ // The handles tell whether the reader still has the same GATT table.
+ typedef struct {
+     uint8_t address[6];
+     uint8_t addressType;
+     PN532_LinkUuid service;
+     PN532_LinkUuid write;
+     PN532_LinkUuid notify;
+     uint16_t serviceHandle;
+     uint16_t writeHandle;
+     uint16_t notifyHandle;
+     char name[32]; // GAP device name, for isPN532Killer()
+ } PN532_LinkRecord;
+
+ class PN532_LinkStore {
+ public:
+     virtual ~PN532_LinkStore() {}
+
+     virtual bool load(PN532_LinkRecord &record) = 0;
+     virtual bool save(const PN532_LinkRecord &record) = 0;
+     virtual void clear() = 0;
+ };
+
+ // Lives as long as the object, e.g. for host builds
+ class PN532_MemoryLinkStore : public PN532_LinkStore {
+ public:
+     bool load(PN532_LinkRecord &record) override
+     {
+         if (_valid)
+         {
+             record = _record;
+         }
+         return _valid;
+     }
+     bool save(const PN532_LinkRecord &record) override
+     {
+         _record = record;
+         _valid = true;
+         return true;
+     }
+     void clear() override { _valid = false; }
+
+ private:
+     PN532_LinkRecord _record = {};
+     bool _valid = false;
+ };
+
+ #if defined(ARDUINO_ARCH_ESP32)
+ // Survives a reboot in NVS. Use one key per reader when keeping several.
+ class PN532_NvsLinkStore : public PN532_LinkStore {
+ public:
+     PN532_NvsLinkStore(const char *key = "link") : _key(key) {}
+
+     bool load(PN532_LinkRecord &record) override
+     {
+         Preferences prefs;
+         if (!prefs.begin(NAMESPACE, true))
+         {
+             return false;
+         }
+         // A record from an older layout has another size and is ignored
+         bool loaded = prefs.getBytesLength(_key) == sizeof(record) &&
+                       prefs.getBytes(_key, &record, sizeof(record)) == sizeof(record);
+         prefs.end();
+         return loaded;
+     }
+     bool save(const PN532_LinkRecord &record) override
+     {
+         Preferences prefs;
+         if (!prefs.begin(NAMESPACE, false))
+         {
+             return false;
+         }
+         bool saved = prefs.putBytes(_key, &record, sizeof(record)) == sizeof(record);
+         prefs.end();
+         return saved;
+     }
+     void clear() override
+     {
+         Preferences prefs;
+         if (prefs.begin(NAMESPACE, false))
+         {
+             prefs.remove(_key);
+             prefs.end();
+         }
+     }
+
+ private:
+     static constexpr const char *NAMESPACE = "pn532";
+     const char *_key;
+ };
+ #endif
+
+ #endif // PN532_LINK_STORE_H
@@ -0,0 +1,98 @@
+/**
+ * @file pn532_log.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Compile-time log levels
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_LOG_H
+ #define PN532_LOG_H
+
+ #include "pn532_platform.h"
+ #include <stdarg.h>
+
+ #define PN532_LOG_LEVEL_NONE 0
+ #define PN532_LOG_LEVEL_ERROR 1
+ #define PN532_LOG_LEVEL_WARN 2
+ #define PN532_LOG_LEVEL_INFO 3
+ #define PN532_LOG_LEVEL_DEBUG 4
+ // Every frame sent and received, byte by byte
+ #define PN532_LOG_LEVEL_TRACE 5
+
+ // Messages above this level are not compiled in at all. Set it with a build
+ // flag, e.g. -DPN532_LOG_LEVEL=PN532_LOG_LEVEL_TRACE. DEBUG and TRACE output
+ // is additionally gated by the debug flag of the PN532 instance.
+ #ifndef PN532_LOG_LEVEL
+ #define PN532_LOG_LEVEL PN532_LOG_LEVEL_DEBUG
+ #endif
+
+ inline void pn532Log(const char *format, ...)
+ {
+     char line[128];
+     va_list args;
+     va_start(args, format);
+     vsnprintf(line, sizeof(line), format, args);
+     va_end(args);
+     Serial.println((const char *)line);
+ }
+
+ // One print per frame instead of two per byte
+ inline void pn532LogFrame(const char *prefix, const uint8_t *data, size_t length)
+ {
+     static const char digits[] = "0123456789ABCDEF";
+     char line[16 + 3 * 64 + 4];
+     size_t pos = snprintf(line, sizeof(line), "%s", prefix);
+     size_t i = 0;
+     // Room for one more byte, the ellipsis and the terminator
+     for (; i < length && pos + 7 <= sizeof(line); i++)
+     {
+         line[pos++] = ' ';
+         line[pos++] = digits[data[i] >> 4];
+         line[pos++] = digits[data[i] & 0x0F];
+     }
+     if (i < length)
+     {
+         memcpy(line + pos, "...", 3);
+         pos += 3;
+     }
+     line[pos] = '\0';
+     Serial.println((const char *)line);
+ }
+
+ #define PN532_LOG_NOTHING() \
+     do                      \
+     {                       \
+     } while (0)
+
+ #if PN532_LOG_LEVEL >= PN532_LOG_LEVEL_ERROR
+ #define PN532_LOGE(...) pn532Log(__VA_ARGS__)
+ #else
+ #define PN532_LOGE(...) PN532_LOG_NOTHING()
+ #endif
+
+ #if PN532_LOG_LEVEL >= PN532_LOG_LEVEL_WARN
+ #define PN532_LOGW(...) pn532Log(__VA_ARGS__)
+ #else
+ #define PN532_LOGW(...) PN532_LOG_NOTHING()
+ #endif
+
+ #if PN532_LOG_LEVEL >= PN532_LOG_LEVEL_INFO
+ #define PN532_LOGI(...) pn532Log(__VA_ARGS__)
+ #else
+ #define PN532_LOGI(...) PN532_LOG_NOTHING()
+ #endif
+
+ #if PN532_LOG_LEVEL >= PN532_LOG_LEVEL_DEBUG
+ #define PN532_LOGD(...) pn532Log(__VA_ARGS__)
+ #else
+ #define PN532_LOGD(...) PN532_LOG_NOTHING()
+ #endif
+
+ #if PN532_LOG_LEVEL >= PN532_LOG_LEVEL_TRACE
+ #define PN532_LOG_FRAME(prefix, data, length) pn532LogFrame(prefix, data, length)
+ #else
+ #define PN532_LOG_FRAME(prefix, data, length) PN532_LOG_NOTHING()
+ #endif
+
+ #endif // PN532_LOG_H
@@ -0,0 +1,182 @@
+/**
+ * @file pn532_metrics.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Per-command latency histograms and protocol health counters
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_metrics.h"
+
+namespace
+{
+    const std::memory_order RELAXED = std::memory_order_relaxed;
+}
+
+uint32_t PN532_Metrics::bucketLimitUs(size_t bucket)
+{
+    return bucket + 1 < BUCKETS ? 256UL << bucket : UINT32_MAX;
+}
+
+uint32_t PN532_Metrics::percentileUs(const uint32_t *histogram, float fraction)
+{
+    uint32_t total = 0;
+    for (size_t i = 0; i < BUCKETS; i++)
+    {
+        total += histogram[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint32_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++)
+    {
+        seen += histogram[i];
+        if (seen >= fraction * total)
+        {
+            return bucketLimitUs(i);
+        }
+    }
+    return bucketLimitUs(BUCKETS - 1);
+}
+
+size_t PN532_Metrics::bucket(uint32_t us)
+{
+    size_t i = 0;
+    while (i + 1 < BUCKETS && us >= bucketLimitUs(i))
+    {
+        i++;
+    }
+    return i;
+}
+
+PN532_Metrics::Slot *PN532_Metrics::slot(uint8_t command)
+{
+    uint8_t count = _slotCount.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (_slots[i].command.load(RELAXED) == command)
+        {
+            return &_slots[i];
+        }
+    }
+    if (count == MAX_COMMANDS)
+    {
+        return nullptr;
+    }
+    // Only the task driving PN532 gets here, so there is a single writer
+    _slots[count].command.store(command, RELAXED);
+    _slotCount.store(count + 1, std::memory_order_release);
+    return &_slots[count];
+}
+
+void PN532_Metrics::recordRequest(uint8_t command, size_t bytes)
+{
+    _bytesOut.fetch_add(bytes, RELAXED);
+    Slot *s = slot(command);
+    if (s)
+    {
+        s->requests.fetch_add(1, RELAXED);
+        s->bytesOut.fetch_add(bytes, RELAXED);
+    }
+}
+
+void PN532_Metrics::recordResponse(
+    uint8_t command, bool errorFrame, uint32_t firstNotifyUs, uint32_t completeUs, uint16_t fragments, uint16_t bytes)
+{
+    Slot *s = slot(command);
+    if (!s)
+    {
+        return;
+    }
+    s->responses.fetch_add(1, RELAXED);
+    if (errorFrame)
+    {
+        s->errorFrames.fetch_add(1, RELAXED);
+    }
+    s->fragments.fetch_add(fragments, RELAXED);
+    s->bytesIn.fetch_add(bytes, RELAXED);
+    s->firstNotifyUs[bucket(firstNotifyUs)].fetch_add(1, RELAXED);
+    s->completeUs[bucket(completeUs)].fetch_add(1, RELAXED);
+}
+
+void PN532_Metrics::recordTimeout(uint8_t command)
+{
+    _timeouts.fetch_add(1, RELAXED);
+    Slot *s = slot(command);
+    if (s)
+    {
+        s->timeouts.fetch_add(1, RELAXED);
+    }
+}
+
+void PN532_Metrics::recordLost(uint8_t command)
+{
+    Slot *s = slot(command);
+    if (s)
+    {
+        s->lost.fetch_add(1, RELAXED);
+    }
+}
+
+void PN532_Metrics::snapshot(Snapshot &out) const
+{
+    out.commandCount = _slotCount.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < out.commandCount; i++)
+    {
+        const Slot &s = _slots[i];
+        CommandStats &c = out.commands[i];
+        c.command = s.command.load(RELAXED);
+        c.requests = s.requests.load(RELAXED);
+        c.responses = s.responses.load(RELAXED);
+        c.errorFrames = s.errorFrames.load(RELAXED);
+        c.timeouts = s.timeouts.load(RELAXED);
+        c.lost = s.lost.load(RELAXED);
+        c.bytesOut = s.bytesOut.load(RELAXED);
+        c.bytesIn = s.bytesIn.load(RELAXED);
+        c.fragments = s.fragments.load(RELAXED);
+        for (size_t b = 0; b < BUCKETS; b++)
+        {
+            c.firstNotifyUs[b] = s.firstNotifyUs[b].load(RELAXED);
+            c.completeUs[b] = s.completeUs[b].load(RELAXED);
+        }
+    }
+    out.notifications = _notifications.load(RELAXED);
+    out.bytesIn = _bytesIn.load(RELAXED);
+    out.bytesOut = _bytesOut.load(RELAXED);
+    out.checksumErrors = _checksumErrors.load(RELAXED);
+    out.crcErrors = _crcErrors.load(RELAXED);
+    out.unmatchedResponses = _unmatchedResponses.load(RELAXED);
+    out.droppedResponses = _droppedResponses.load(RELAXED);
+    out.timeouts = _timeouts.load(RELAXED);
+}
+
+void PN532_Metrics::reset()
+{
+    for (Slot &s : _slots)
+    {
+        s.requests.store(0, RELAXED);
+        s.responses.store(0, RELAXED);
+        s.errorFrames.store(0, RELAXED);
+        s.timeouts.store(0, RELAXED);
+        s.lost.store(0, RELAXED);
+        s.bytesOut.store(0, RELAXED);
+        s.bytesIn.store(0, RELAXED);
+        s.fragments.store(0, RELAXED);
+        for (size_t b = 0; b < BUCKETS; b++)
+        {
+            s.firstNotifyUs[b].store(0, RELAXED);
+            s.completeUs[b].store(0, RELAXED);
+        }
+    }
+    _notifications.store(0, RELAXED);
+    _bytesIn.store(0, RELAXED);
+    _bytesOut.store(0, RELAXED);
+    _checksumErrors.store(0, RELAXED);
+    _crcErrors.store(0, RELAXED);
+    _unmatchedResponses.store(0, RELAXED);
+    _droppedResponses.store(0, RELAXED);
+    _timeouts.store(0, RELAXED);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file pn532_metrics.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Per-command latency histograms and protocol health counters
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_METRICS_H
+ #define PN532_METRICS_H
+
+ #include <atomic>
+ #include <stddef.h>
+ #include <stdint.h>
+
+ // Counters are relaxed atomics: recording is a handful of increments, and
+ // snapshot()/reset() may run on any task, e.g. a telemetry timer. Per-command
+ // figures are recorded by the task driving PN532, the receive path only
+ // bumps the global counters.
+ class PN532_Metrics {
+ public:
+     // Latency buckets: bucket 0 counts below 256 us, bucket i below 256 << i us,
+     // the last one everything slower
+     static const size_t BUCKETS = 16;
+     // Distinct command codes tracked, later ones are only counted globally
+     static const size_t MAX_COMMANDS = 16;
+
+     typedef struct {
+         uint8_t command;
+         uint32_t requests;       // frames written
+         uint32_t responses;      // replies matched to a request
+         uint32_t errorFrames;    // replies that were PN532 error frames
+         uint32_t timeouts;       // requests that got no reply in time
+         uint32_t lost;           // requests whose reply was skipped for a later one
+         uint32_t bytesOut;       // frame bytes written
+         uint32_t bytesIn;        // notification bytes up to and including the reply, ACK too
+         uint32_t fragments;      // notifications those bytes came in, divide by responses
+         uint32_t firstNotifyUs[BUCKETS]; // write to the first notification after it
+         uint32_t completeUs[BUCKETS];    // write to the reply frame being complete
+     } CommandStats;
+
+     typedef struct {
+         CommandStats commands[MAX_COMMANDS];
+         uint8_t commandCount;
+         uint32_t notifications;
+         uint32_t bytesIn;
+         uint32_t bytesOut;
+         uint32_t checksumErrors;     // frames dropped for a bad LCS/DCS
+         uint32_t crcErrors;          // card replies dropped for a bad CRC_A/ISO 15693 CRC
+         uint32_t unmatchedResponses; // replies no in-flight request was waiting for
+         uint32_t droppedResponses;   // replies lost because the response ring was full
+         uint32_t timeouts;
+     } Snapshot;
+
+     PN532_Metrics() { reset(); }
+
+     void snapshot(Snapshot &out) const;
+     // Zeroes every counter, the command slots stay assigned
+     void reset();
+
+     // Upper bound of a bucket in microseconds, UINT32_MAX for the last one
+     static uint32_t bucketLimitUs(size_t bucket);
+     // Upper bound of the bucket holding the given fraction (0..1) of the samples
+     static uint32_t percentileUs(const uint32_t *histogram, float fraction);
+
+     // Receive path
+     void recordNotification(size_t bytes)
+     {
+         _notifications.fetch_add(1, std::memory_order_relaxed);
+         _bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+     }
+     void recordChecksumError() { _checksumErrors.fetch_add(1, std::memory_order_relaxed); }
+     void recordCrcError() { _crcErrors.fetch_add(1, std::memory_order_relaxed); }
+     void recordDroppedResponse() { _droppedResponses.fetch_add(1, std::memory_order_relaxed); }
+
+     // Task driving PN532
+     void recordRequest(uint8_t command, size_t bytes);
+     void recordResponse(
+         uint8_t command, bool errorFrame, uint32_t firstNotifyUs, uint32_t completeUs, uint16_t fragments,
+         uint16_t bytes
+     );
+     void recordTimeout(uint8_t command);
+     void recordLost(uint8_t command);
+     void recordUnmatched() { _unmatchedResponses.fetch_add(1, std::memory_order_relaxed); }
+
+ private:
+     typedef std::atomic<uint32_t> Counter;
+
+     struct Slot {
+         std::atomic<uint8_t> command;
+         Counter requests;
+         Counter responses;
+         Counter errorFrames;
+         Counter timeouts;
+         Counter lost;
+         Counter bytesOut;
+         Counter bytesIn;
+         Counter fragments;
+         Counter firstNotifyUs[BUCKETS];
+         Counter completeUs[BUCKETS];
+     };
+
+     Slot _slots[MAX_COMMANDS];
+     std::atomic<uint8_t> _slotCount{0};
+     Counter _notifications;
+     Counter _bytesIn;
+     Counter _bytesOut;
+     Counter _checksumErrors;
+     Counter _crcErrors;
+     Counter _unmatchedResponses;
+     Counter _droppedResponses;
+     Counter _timeouts;
+
+     Slot *slot(uint8_t command);
+     static size_t bucket(uint32_t us);
+ };
+
+ #endif // PN532_METRICS_H
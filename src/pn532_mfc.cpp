@@ -0,0 +1,405 @@
+/**
+ * @file pn532_mfc.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief MIFARE Classic bulk operations on top of the PN532 command layer
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_mfc.h"
+#include <algorithm>
+
+namespace
+{
+    const uint8_t STATUS_OK = 0x00;
+    const uint8_t STATUS_MIFARE_ERROR = 0x14;
+    // Requests PN532 keeps queued, an auth attempt plus the reselect it needs take two
+    const size_t QUEUE_DEPTH = 8;
+    // Reselects in a row that may fail before the card counts as gone
+    const int MAX_RESELECT_FAILURES = 3;
+    typedef PN532_StaticFrame<PN532::InListPassiveTarget, 0x01, 0x00> ReselectFrame;
+
+    uint64_t keyValue(const uint8_t *key)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            value = (value << 8) | key[i];
+        }
+        return value;
+    }
+}
+
+uint8_t PN532_MifareClassic::sectorCount(uint8_t sak)
+{
+    switch (sak)
+    {
+    case 0x09:
+        return 5;
+    case 0x18:
+    case 0x98:
+        return 40;
+    default:
+        return 16;
+    }
+}
+
+bool PN532_MifareClassic::reselect()
+{
+    PN532::Iso14aTagInfo tag = _nfc.hf14aScan();
+    return !tag.uid.empty();
+}
+
+bool PN532_MifareClassic::dump(Dump &out, const SectorKey *keys, size_t keyCount)
+{
+    unsigned long startTime = millis();
+    out = Dump();
+
+    // Reuse the selection from an earlier hf14aScan, only scan when there is none
+    if (_nfc.hf14aTagInfo.uid.size() < 4 && !reselect())
+    {
+        return false;
+    }
+
+    out.sectors = sectorCount(_nfc.hf14aTagInfo.sak);
+    out.blocks = firstBlock(out.sectors - 1) + blocksInSector(out.sectors - 1);
+    out.data.assign(out.blocks * 16, 0x00);
+    out.blockRead.assign(out.blocks, false);
+
+    bool needReselect = false;
+    for (uint8_t sector = 0; sector < out.sectors; sector++)
+    {
+        SectorKey key;
+        if (keys && sector < keyCount)
+        {
+            key = keys[sector];
+        }
+        else
+        {
+            memcpy(key.key, _nfc.mifareKey, 6);
+            key.keyA = true;
+            key.known = true;
+        }
+        if (!key.known)
+        {
+            continue;
+        }
+
+        // The card only drops out of the selected state after a failure
+        if (needReselect)
+        {
+            out.reselects++;
+            if (!reselect())
+            {
+                break;
+            }
+            needReselect = false;
+        }
+
+        bool authenticated = false;
+        for (int attempt = 0; attempt < 2 && !authenticated; attempt++)
+        {
+            authenticated = _nfc.mfAuth(_nfc.hf14aTagInfo.uid, firstBlock(sector), key.key, key.keyA);
+            if (authenticated)
+            {
+                break;
+            }
+            out.authFailures++;
+            needReselect = true;
+            // A wrong key is final; anything else means the selection was lost
+            if (_nfc.cmdResponse.dataSize >= 1 && _nfc.cmdResponse.data[0] == STATUS_MIFARE_ERROR)
+            {
+                break;
+            }
+            out.reselects++;
+            if (!reselect())
+            {
+                break;
+            }
+            needReselect = false;
+        }
+        if (!authenticated)
+        {
+            continue;
+        }
+
+        if (!readSector(sector, out))
+        {
+            needReselect = true;
+            continue;
+        }
+
+        // The card never reveals key A, put the one that worked into the trailer
+        if (key.keyA)
+        {
+            uint8_t trailer = firstBlock(sector) + blocksInSector(sector) - 1;
+            memcpy(out.data.data() + trailer * 16, key.key, 6);
+        }
+        out.sectorsRead++;
+    }
+
+    out.elapsedMs = millis() - startTime;
+    out.blocksPerSecond = out.elapsedMs > 0 ? out.blocksRead * 1000.0f / out.elapsedMs : 0;
+    return out.sectorsRead == out.sectors;
+}
+
+bool PN532_MifareClassic::readSector(uint8_t sector, Dump &out)
+{
+    // Queue every block of the sector so the reads go out back-to-back
+    uint8_t first = firstBlock(sector);
+    uint8_t count = blocksInSector(sector);
+    uint32_t timeoutMs = _nfc.getCommandTimeout(PN532::InDataExchange);
+    bool complete = true;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t block = first + i;
+        PN532::CommandCallback onRead = [&out, &complete, block](bool ok, const PN532::CmdResponse &rsp)
+        {
+            if (!ok || rsp.dataSize < 17 || rsp.data[0] != STATUS_OK)
+            {
+                complete = false;
+                return;
+            }
+            memcpy(out.data.data() + block * 16, rsp.data + 1, 16);
+            out.blockRead[block] = true;
+            out.blocksRead++;
+        };
+        while (!_nfc.submit(PN532::InDataExchange, {0x01, 0x30, block}, onRead))
+        {
+            if (_nfc.pending() == 0)
+            {
+                return false;
+            }
+            _nfc.process(timeoutMs);
+        }
+    }
+    // The callbacks reference this frame, wait for all of them
+    while (_nfc.pending() > 0)
+    {
+        _nfc.process(timeoutMs);
+    }
+    return complete;
+}
+
+bool PN532_MifareClassic::checkKeys(
+    const uint8_t (*keys)[6], size_t keyCount, uint64_t sectorMask, KeyMap &out, bool keyA, bool keyB)
+{
+    unsigned long startTime = millis();
+    out = KeyMap();
+
+    if (_nfc.hf14aTagInfo.uid.size() < 4 && !reselect())
+    {
+        return false;
+    }
+    out.sectors = sectorCount(_nfc.hf14aTagInfo.sak);
+
+    // Most successful keys of earlier cards first, dictionary order otherwise
+    std::vector<size_t> order(keyCount);
+    std::vector<uint32_t> hits(keyCount, 0);
+    for (size_t i = 0; i < keyCount; i++)
+    {
+        order[i] = i;
+        auto it = _keyHits.find(keyValue(keys[i]));
+        hits[i] = it != _keyHits.end() ? it->second : 0;
+    }
+    std::stable_sort(order.begin(), order.end(), [&hits](size_t a, size_t b) { return hits[a] > hits[b]; });
+
+    std::vector<const uint8_t *> foundKeys;
+    std::vector<const uint8_t *> candidates;
+    candidates.reserve(keyCount);
+    bool needReselect = false;
+    bool complete = true;
+
+    for (uint8_t sector = 0; sector < out.sectors; sector++)
+    {
+        if (!(sectorMask & (1ULL << sector)))
+        {
+            continue;
+        }
+
+        for (int type = 0; type < 2; type++)
+        {
+            bool useKeyA = type == 0;
+            if ((useKeyA && !keyA) || (!useKeyA && !keyB))
+            {
+                continue;
+            }
+
+            // Cards often share keys between sectors, so try the ones that already worked first
+            candidates.assign(foundKeys.begin(), foundKeys.end());
+            for (size_t i : order)
+            {
+                bool seen = false;
+                for (const uint8_t *found : foundKeys)
+                {
+                    seen = seen || memcmp(found, keys[i], 6) == 0;
+                }
+                if (!seen)
+                {
+                    candidates.push_back(keys[i]);
+                }
+            }
+
+            int index = findKey(sector, useKeyA, candidates, needReselect, out);
+            if (index == -2)
+            {
+                // Card gone
+                out.elapsedMs = millis() - startTime;
+                return false;
+            }
+            if (index < 0)
+            {
+                complete = false;
+                continue;
+            }
+
+            const uint8_t *key = candidates[index];
+            SectorKey &slot = useKeyA ? out.keyA[sector] : out.keyB[sector];
+            memcpy(slot.key, key, 6);
+            slot.keyA = useKeyA;
+            slot.known = true;
+            out.keysFound++;
+            _keyHits[keyValue(key)]++;
+            if ((size_t)index >= foundKeys.size())
+            {
+                foundKeys.insert(foundKeys.begin(), key);
+            }
+        }
+    }
+
+    out.elapsedMs = millis() - startTime;
+    out.keysPerSecond = out.elapsedMs > 0 ? out.attempts * 1000.0f / out.elapsedMs : 0;
+    return complete;
+}
+
+int PN532_MifareClassic::findKey(
+    uint8_t sector, bool keyA, const std::vector<const uint8_t *> &candidates, bool &needReselect, KeyMap &out)
+{
+    const std::vector<uint8_t> &uid = _nfc.hf14aTagInfo.uid;
+    uint32_t timeoutMs = _nfc.getCommandTimeout(PN532::InDataExchange);
+    int found = -1;
+    bool lost = false;
+    // Set while cancel() runs the callbacks of requests that never went out
+    bool cancelling = false;
+    // An attempt that was already on the air failed after the hit
+    bool trailingFailure = false;
+    size_t next = 0;
+    // Bumped when attempts are retried, the callbacks of older ones are ignored
+    int generation = 0;
+    int reselectFailures = 0;
+
+    // Build the 13 byte auth payload once, only the key changes per attempt
+    uint8_t auth[13] = {0x01, (uint8_t)(keyA ? 0x60 : 0x61), firstBlock(sector)};
+    memcpy(auth + 9, uid.data() + uid.size() - 4, 4);
+
+    auto stop = [this, &cancelling]()
+    {
+        cancelling = true;
+        _nfc.cancel();
+        cancelling = false;
+    };
+    auto onReselect = [&](size_t retryFrom, int gen) -> PN532::CommandCallback
+    {
+        return [&, retryFrom, gen](bool ok, const PN532::CmdResponse &rsp)
+        {
+            bool selected = ok && rsp.dataSize >= 1 && rsp.data[0] != 0;
+            if (cancelling || lost || gen != generation)
+            {
+                return;
+            }
+            if (found >= 0)
+            {
+                trailingFailure = trailingFailure && !selected;
+                return;
+            }
+            if (selected)
+            {
+                reselectFailures = 0;
+                return;
+            }
+            if (++reselectFailures > MAX_RESELECT_FAILURES)
+            {
+                lost = true;
+                stop();
+                return;
+            }
+            // The attempts after a lost reselect met an idle card, try them again
+            generation++;
+            stop();
+            out.attempts -= next - retryFrom;
+            next = retryFrom;
+            needReselect = true;
+        };
+    };
+
+    while (found < 0 && !lost && (next < candidates.size() || _nfc.pending() > 0))
+    {
+        // A failed auth drops the card to idle, InListPassiveTarget is the
+        // single round trip that gets it selected again. Keep attempts and
+        // their reselects queued back-to-back.
+        while (found < 0 && !lost && next < candidates.size() && _nfc.pending() + 2 <= QUEUE_DEPTH)
+        {
+            if (needReselect)
+            {
+                if (!_nfc.submit<ReselectFrame>(onReselect(next, generation)))
+                {
+                    break;
+                }
+                out.reselects++;
+                needReselect = false;
+            }
+            memcpy(auth + 3, candidates[next], 6);
+            int index = next;
+            int gen = generation;
+            bool submitted = _nfc.submit(
+                PN532::InDataExchange, auth, sizeof(auth),
+                [&, index, gen](bool ok, const PN532::CmdResponse &rsp)
+                {
+                    bool authenticated = ok && rsp.dataSize >= 1 && rsp.data[0] == STATUS_OK;
+                    if (cancelling || lost || gen != generation)
+                    {
+                        return;
+                    }
+                    if (found >= 0)
+                    {
+                        trailingFailure = trailingFailure || !authenticated;
+                        return;
+                    }
+                    if (authenticated)
+                    {
+                        found = index;
+                        stop();
+                    }
+                });
+            if (!submitted)
+            {
+                break;
+            }
+            next++;
+            out.attempts++;
+            needReselect = true;
+        }
+        _nfc.process(timeoutMs);
+    }
+    // The callbacks reference this frame, wait for all of them
+    while (_nfc.pending() > 0)
+    {
+        _nfc.process(timeoutMs);
+    }
+
+    if (lost)
+    {
+        return -2;
+    }
+    // After a hit the card stays selected unless an attempt already on the air failed
+    needReselect = found < 0 || trailingFailure;
+    return found;
+}
+
+void PN532_MifareClassic::toSectorKeys(const KeyMap &keyMap, SectorKey *keys, size_t keyCount)
+{
+    for (size_t sector = 0; sector < keyCount && sector < 40; sector++)
+    {
+        keys[sector] = keyMap.keyA[sector].known ? keyMap.keyA[sector] : keyMap.keyB[sector];
+    }
+}
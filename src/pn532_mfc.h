@@ -0,0 +1,85 @@
+/**
+ * @file pn532_mfc.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief MIFARE Classic bulk operations on top of the PN532 command layer
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_MFC_H
+ #define PN532_MFC_H
+
+ #include "pn532.h"
+ #include <map>
+
+ class PN532_MifareClassic {
+ public:
+     typedef struct {
+         uint8_t key[6];
+         bool keyA;
+         bool known;
+     } SectorKey;
+
+     typedef struct {
+         std::vector<uint8_t> data;   // 16 bytes per block, trailers carry the key used
+         std::vector<bool> blockRead; // false where the block could not be read
+         uint16_t blocks;
+         uint16_t blocksRead;
+         uint8_t sectors;
+         uint8_t sectorsRead;
+         uint16_t authFailures;
+         uint16_t reselects;
+         unsigned long elapsedMs;
+         float blocksPerSecond;
+     } Dump;
+
+     typedef struct {
+         SectorKey keyA[40];
+         SectorKey keyB[40];
+         uint8_t sectors;
+         uint8_t keysFound;
+         uint32_t attempts;
+         uint16_t reselects;
+         unsigned long elapsedMs;
+         float keysPerSecond;
+     } KeyMap;
+
+     PN532_MifareClassic(PN532 &nfc) : _nfc(nfc) {}
+
+     static uint8_t sectorCount(uint8_t sak);
+     static uint8_t firstBlock(uint8_t sector) { return sector < 32 ? sector * 4 : 128 + (sector - 32) * 16; }
+     static uint8_t blocksInSector(uint8_t sector) { return sector < 32 ? 4 : 16; }
+     static uint8_t blockToSector(uint8_t block) { return block < 128 ? block / 4 : 32 + (block - 128) / 16; }
+
+     // Reads the whole card, authenticating once per sector. keys holds one
+     // entry per sector; without it key A = nfc.mifareKey is used everywhere.
+     // Returns true when every sector was read.
+     bool dump(Dump &out, const SectorKey *keys = nullptr, size_t keyCount = 0);
+
+     // Tries a key dictionary against every sector set in sectorMask (bit n =
+     // sector n). Keys already found on another sector are tried first, the
+     // rest in order of how often they hit on earlier cards. Returns true when
+     // every requested key was found.
+     bool checkKeys(
+         const uint8_t (*keys)[6], size_t keyCount, uint64_t sectorMask, KeyMap &out, bool keyA = true,
+         bool keyB = false
+     );
+     // Hit counts collected by checkKeys, keyed by the 48-bit key value
+     const std::map<uint64_t, uint32_t> &getKeyStats() { return _keyHits; }
+     void resetKeyStats() { _keyHits.clear(); }
+     // Per-sector keys for dump(), key A where both are known
+     static void toSectorKeys(const KeyMap &keyMap, SectorKey *keys, size_t keyCount);
+
+ private:
+     PN532 &_nfc;
+     std::map<uint64_t, uint32_t> _keyHits;
+
+     bool reselect();
+     int findKey(
+         uint8_t sector, bool keyA, const std::vector<const uint8_t *> &candidates, bool &needReselect,
+         KeyMap &out
+     );
+     bool readSector(uint8_t sector, Dump &out);
+ };
+
+ #endif // PN532_MFC_H
@@ -0,0 +1,334 @@
+/**
+ * @file pn532_mfu.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief MIFARE Ultralight and NTAG bulk operations on top of the PN532 command layer
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_mfu.h"
+#include <algorithm>
+
+namespace
+{
+    const uint8_t STATUS_OK = 0x00;
+    const uint8_t ACK = 0x0A;
+    // READ always returns four pages
+    const uint8_t READ_PAGES = 4;
+}
+
+const uint8_t PN532_Ultralight::MAX_READ_PAGES;
+const uint8_t PN532_Ultralight::DEFAULT_READ_PAGES;
+
+void PN532_Ultralight::setMaxReadPages(uint8_t pages)
+{
+    _maxReadPages = std::max<uint8_t>(1, std::min(pages, MAX_READ_PAGES));
+}
+
+bool PN532_Ultralight::reselect()
+{
+    PN532::Iso14aTagInfo tag = _nfc.hf14aScan();
+    return !tag.uid.empty();
+}
+
+void PN532_Ultralight::rawMode()
+{
+    // CRC_A is appended and checked by sendData
+    _nfc.writeRegister(PN532::REG_TX_MODE, 0x00);
+    _nfc.writeRegister(PN532::REG_RX_MODE, 0x00);
+}
+
+bool PN532_Ultralight::getVersion(uint8_t version[8])
+{
+    rawMode();
+    const uint8_t command[] = {0x60};
+    uint8_t reply[1 + 8 + 2];
+    if (_nfc.sendData(command, sizeof(command), true, reply, sizeof(reply)) != sizeof(reply) || reply[0] != STATUS_OK)
+    {
+        return false;
+    }
+    memcpy(version, reply + 1, 8);
+    return true;
+}
+
+uint16_t PN532_Ultralight::pageCount(const uint8_t version[8])
+{
+    // Storage size byte: Ultralight EV1 and NTAG21x
+    switch (version[6])
+    {
+    case 0x0B:
+        return 20; // MF0UL11, NTAG210
+    case 0x0E:
+        return 41; // MF0UL21, NTAG212
+    case 0x0F:
+        return 45; // NTAG213
+    case 0x11:
+        return 135; // NTAG215
+    case 0x13:
+        return 231; // NTAG216
+    default:
+        return 0;
+    }
+}
+
+size_t PN532_Ultralight::fastRead(uint8_t first, uint8_t last, uint8_t *out, size_t capacity)
+{
+    size_t pages = (size_t)last - first + 1;
+    if (last < first || pages > MAX_READ_PAGES || pages * 4 > capacity)
+    {
+        return 0;
+    }
+    rawMode();
+    const uint8_t command[] = {0x3A, first, last};
+    // Status, pages, CRC_A
+    uint8_t reply[PN532_FrameEncoder::MAX_PAYLOAD];
+    if (_nfc.sendData(command, sizeof(command), true, reply, sizeof(reply)) != pages * 4 + 3 || reply[0] != STATUS_OK)
+    {
+        return 0;
+    }
+    memcpy(out, reply + 1, pages * 4);
+    return pages * 4;
+}
+
+size_t PN532_Ultralight::readPages(uint8_t first, uint8_t count, bool fast, uint8_t *out, size_t capacity)
+{
+    if (fast)
+    {
+        return fastRead(first, first + count - 1, out, capacity);
+    }
+    if (count > READ_PAGES || (size_t)count * 4 > capacity)
+    {
+        return 0;
+    }
+    rawMode();
+    const uint8_t command[] = {0x30, first};
+    uint8_t reply[1 + READ_PAGES * 4 + 2];
+    if (_nfc.sendData(command, sizeof(command), true, reply, sizeof(reply)) != sizeof(reply) || reply[0] != STATUS_OK)
+    {
+        return 0;
+    }
+    memcpy(out, reply + 1, count * 4);
+    return count * 4;
+}
+
+uint16_t PN532_Ultralight::probePages(Dump &out)
+{
+    // READ is refused from the first page past the end. The READ before the
+    // refused one already returned the last pages, rolled over or not.
+    uint8_t pages[READ_PAGES * 4];
+    uint16_t page = 0;
+    while (page < 256)
+    {
+        out.reads++;
+        if (readPages(page, READ_PAGES, false, pages, sizeof(pages)) == 0)
+        {
+            break;
+        }
+        out.data.insert(out.data.end(), pages, pages + sizeof(pages));
+        page += READ_PAGES;
+    }
+    if (page == 0 || page == 256)
+    {
+        return page;
+    }
+
+    // The end is one of the last three pages; each refusal leaves the card idle
+    uint16_t end = page;
+    bool idle = true;
+    for (uint16_t last = page - READ_PAGES + 1; last < page; last++)
+    {
+        if (idle)
+        {
+            out.reselects++;
+            if (!reselect())
+            {
+                return 0;
+            }
+        }
+        out.reads++;
+        idle = readPages(last, 1, false, pages, sizeof(pages)) == 0;
+        if (idle)
+        {
+            end = last;
+            break;
+        }
+    }
+    if (idle)
+    {
+        out.reselects++;
+        reselect();
+    }
+    return end;
+}
+
+bool PN532_Ultralight::dump(Dump &out)
+{
+    unsigned long startTime = millis();
+    out = Dump();
+
+    // Reuse the selection from an earlier hf14aScan, only scan when there is none
+    if (_nfc.hf14aTagInfo.uid.size() < 4 && !reselect())
+    {
+        return false;
+    }
+
+    // Cards that know GET_VERSION also know FAST_READ; the others are read
+    // four pages at a time and need selecting again after the silent GET_VERSION
+    uint8_t version[8];
+    out.reads++;
+    bool fast = getVersion(version);
+    out.pages = fast ? pageCount(version) : 0;
+    if (!fast)
+    {
+        out.reselects++;
+        if (!reselect())
+        {
+            return false;
+        }
+    }
+    if (out.pages == 0)
+    {
+        // Unknown size: read until the card refuses
+        out.pages = probePages(out);
+        out.data.resize(out.pages * 4);
+        out.pageRead.assign(out.pages, true);
+        out.pagesRead = out.pages;
+        out.chunk = READ_PAGES;
+        out.elapsedMs = millis() - startTime;
+        out.pagesPerSecond = out.elapsedMs > 0 ? out.pagesRead * 1000.0f / out.elapsedMs : 0;
+        return out.pages > 0;
+    }
+    out.data.assign(out.pages * 4, 0x00);
+    out.pageRead.assign(out.pages, false);
+
+    uint8_t ceiling = _maxReadPages;
+    uint8_t chunk = ceiling;
+    // The refused range is read in halves up to windowEnd. Past it the chunk
+    // grows back, unless every page in it was readable: then the range was
+    // only too long for the card and the smaller chunk is the new ceiling.
+    uint16_t windowEnd = 0;
+    bool windowSkipped = false;
+    uint16_t page = 0;
+    while (page < out.pages)
+    {
+        uint8_t count = std::min<uint16_t>(chunk, out.pages - page);
+        out.reads++;
+        if (readPages(page, count, true, out.data.data() + page * 4, out.data.size() - page * 4) > 0)
+        {
+            std::fill(out.pageRead.begin() + page, out.pageRead.begin() + page + count, true);
+            out.pagesRead += count;
+            out.chunk = std::max(out.chunk, count);
+            page += count;
+        }
+        else
+        {
+            // The refused read left the card idle
+            out.reselects++;
+            if (!reselect())
+            {
+                break;
+            }
+            if (chunk > 1)
+            {
+                windowEnd = page + count;
+                windowSkipped = false;
+                chunk = (chunk + 1) / 2;
+                continue;
+            }
+            page++; // e.g. behind the password protection
+            windowSkipped = true;
+        }
+
+        if (windowEnd > 0 && page >= windowEnd)
+        {
+            if (windowSkipped)
+            {
+                chunk = ceiling;
+            }
+            else
+            {
+                ceiling = chunk;
+            }
+            windowEnd = 0;
+        }
+    }
+
+    out.elapsedMs = millis() - startTime;
+    out.pagesPerSecond = out.elapsedMs > 0 ? out.pagesRead * 1000.0f / out.elapsedMs : 0;
+    return out.pagesRead == out.pages;
+}
+
+bool PN532_Ultralight::write(uint8_t firstPage, const uint8_t *data, size_t length, uint16_t *written)
+{
+    size_t pages = length / 4;
+    uint16_t acked = 0;
+    if (written)
+    {
+        *written = 0;
+    }
+    if (pages == 0 || length % 4 || firstPage + pages > 256)
+    {
+        return false;
+    }
+    if (_nfc.hf14aTagInfo.uid.size() < 4 && !reselect())
+    {
+        return false;
+    }
+
+    // Skip pages that already hold the data; a card without FAST_READ is
+    // selected again and written in full
+    std::vector<uint8_t> current(length);
+    bool compare = true;
+    for (size_t page = 0; page < pages && compare; page += _maxReadPages)
+    {
+        uint8_t count = std::min<size_t>(_maxReadPages, pages - page);
+        compare = fastRead(firstPage + page, firstPage + page + count - 1, current.data() + page * 4, length - page * 4) > 0;
+    }
+    if (!compare && !reselect())
+    {
+        return false;
+    }
+
+    // WRITE takes one page, queue them all so they go out back-to-back
+    rawMode();
+    uint32_t timeoutMs = _nfc.getCommandTimeout(PN532::InCommunicateThru);
+    bool complete = true;
+    for (size_t page = 0; page < pages; page++)
+    {
+        const uint8_t *src = data + page * 4;
+        if (compare && memcmp(current.data() + page * 4, src, 4) == 0)
+        {
+            continue;
+        }
+        uint8_t command[8] = {0xA2, (uint8_t)(firstPage + page), src[0], src[1], src[2], src[3]};
+        PN532_Crc::appendCrcA(command, 6);
+        PN532::CommandCallback onWrite = [&complete, &acked](bool ok, const PN532::CmdResponse &rsp)
+        {
+            // 4-bit ACK, anything else is a NAK
+            if (!ok || rsp.dataSize != 2 || rsp.data[0] != STATUS_OK || rsp.data[1] != ACK)
+            {
+                complete = false;
+                return;
+            }
+            acked++;
+        };
+        while (!_nfc.submit(PN532::InCommunicateThru, command, sizeof(command), onWrite))
+        {
+            if (_nfc.pending() == 0)
+            {
+                return false;
+            }
+            _nfc.process(timeoutMs);
+        }
+    }
+    // The callbacks reference this frame, wait for all of them
+    while (_nfc.pending() > 0)
+    {
+        _nfc.process(timeoutMs);
+    }
+    if (written)
+    {
+        *written = acked;
+    }
+    return complete;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file pn532_mfu.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief MIFARE Ultralight and NTAG bulk operations on top of the PN532 command layer
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_MFU_H
+ #define PN532_MFU_H
+
+ #include "pn532.h"
+
+ // Talks to the card directly through InCommunicateThru with CRC_A checked
+ // on every reply. FAST_READ returns a whole range of pages per round trip,
+ // so an NTAG216 dump takes 4 FAST_READs instead of 58 READs.
+ class PN532_Ultralight {
+ public:
+     // Pages per FAST_READ whose reply (status, pages, CRC_A) still fits a
+     // normal frame, and the largest extended frame the reader sends
+     static const uint8_t DEFAULT_READ_PAGES = (PN532_FrameEncoder::MAX_NORMAL_PAYLOAD - 3) / 4;
+     static const uint8_t MAX_READ_PAGES = (PN532_FrameEncoder::MAX_PAYLOAD - 3) / 4;
+
+     typedef struct {
+         std::vector<uint8_t> data;   // 4 bytes per page
+         std::vector<bool> pageRead; // false where the page could not be read
+         uint16_t pages;
+         uint16_t pagesRead;
+         uint8_t chunk;  // pages per FAST_READ the card and reader accepted
+         uint16_t reads;     // round trips, GET_VERSION included
+         uint16_t reselects; // after a refused read or the GET_VERSION of an older card
+         unsigned long elapsedMs;
+         float pagesPerSecond;
+     } Dump;
+
+     PN532_Ultralight(PN532 &nfc) : _nfc(nfc) {}
+
+     // DEFAULT_READ_PAGES unless set; up to MAX_READ_PAGES when the reader
+     // passes extended frames through
+     void setMaxReadPages(uint8_t pages);
+
+     // GET_VERSION, 8 bytes. Cards without it (Ultralight, NTAG203) do not
+     // answer and are left idle.
+     bool getVersion(uint8_t version[8]);
+     // Pages of the card a GET_VERSION reply describes, 0 if unknown
+     static uint16_t pageCount(const uint8_t version[8]);
+
+     // FAST_READ of pages first to last. Returns the bytes copied, 0 if the
+     // card refused the range, which leaves it idle.
+     size_t fastRead(uint8_t first, uint8_t last, uint8_t *out, size_t capacity);
+
+     // Reads the whole card, sized by GET_VERSION. Without it, READ goes on
+     // until the card refuses a page, which is then taken as the end; pages
+     // behind a password end it early. Ranges the reader or card reject are
+     // halved down to single pages. Returns true when every page was read.
+     bool dump(Dump &out);
+
+     // Writes length / 4 pages from firstPage. The current content is read
+     // first and only pages that differ are written, queued back-to-back.
+     // Returns true when every write was acknowledged; written counts them.
+     bool write(uint8_t firstPage, const uint8_t *data, size_t length, uint16_t *written = nullptr);
+
+ private:
+     PN532 &_nfc;
+     uint8_t _maxReadPages = DEFAULT_READ_PAGES;
+
+     bool reselect();
+     void rawMode();
+     // FAST_READ, or READ of at most four pages
+     size_t readPages(uint8_t first, uint8_t count, bool fast, uint8_t *out, size_t capacity);
+     // Reads with READ into out.data until refused, returns the pages found
+     uint16_t probePages(Dump &out);
+ };
+
+ #endif // PN532_MFU_H
@@ -0,0 +1,115 @@
+/**
+ * @file pn532_platform.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Arduino runtime, or a minimal stand-in when building on a desktop host
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_PLATFORM_H
+ #define PN532_PLATFORM_H
+
+ #if defined(ARDUINO)
+
+ #include <Arduino.h>
+
+ #else
+
+ // Just enough of the Arduino core for the protocol engine and the simulator
+ // to build and run on Linux, e.g. for benchmarks.
+ #include <algorithm>
+ #include <cctype>
+ #include <chrono>
+ #include <cstdarg>
+ #include <cstdint>
+ #include <cstdio>
+ #include <cstring>
+ #include <string>
+ #include <sys/types.h>
+ #include <thread>
+
+ #define HEX 16
+ #define DEC 10
+
+ inline unsigned long millis()
+ {
+     static const auto start = std::chrono::steady_clock::now();
+     return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+ }
+
+ inline unsigned long micros()
+ {
+     static const auto start = std::chrono::steady_clock::now();
+     return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+ }
+
+ inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+ class String {
+ public:
+     String(const char *str = "") : _str(str ? str : "") {}
+     String(const std::string &str) : _str(str) {}
+     String(unsigned long value, unsigned char base = DEC)
+     {
+         char buf[24];
+         snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%lu", value);
+         _str = buf;
+     }
+     String(uint8_t value, unsigned char base = DEC) : String((unsigned long)value, base) {}
+     String(int value, unsigned char base = DEC) : String((unsigned long)value, base) {}
+
+     String &operator+=(const String &other)
+     {
+         _str += other._str;
+         return *this;
+     }
+     String &operator+=(const char *other)
+     {
+         _str += other;
+         return *this;
+     }
+     bool operator==(const String &other) const { return _str == other._str; }
+     bool operator!=(const String &other) const { return _str != other._str; }
+     void toUpperCase() { std::transform(_str.begin(), _str.end(), _str.begin(), ::toupper); }
+     unsigned int length() const { return _str.length(); }
+     const char *c_str() const { return _str.c_str(); }
+
+ private:
+     std::string _str;
+ };
+
+ class HostSerial {
+ public:
+     void print(const char *str) { fputs(str, stdout); }
+     void print(const String &str) { print(str.c_str()); }
+     void print(unsigned long value, int base = DEC) { printf(base == HEX ? "%lX" : "%lu", value); }
+     void print(long value, int base = DEC) { printf(base == HEX ? "%lX" : "%ld", value); }
+     void print(unsigned int value, int base = DEC) { print((unsigned long)value, base); }
+     void print(int value, int base = DEC) { print((long)value, base); }
+     void print(uint8_t value, int base = DEC) { print((unsigned long)value, base); }
+     void print(uint16_t value, int base = DEC) { print((unsigned long)value, base); }
+     void println() { print("\n"); }
+     template <typename T> void println(const T &value)
+     {
+         print(value);
+         println();
+     }
+     template <typename T> void println(const T &value, int base)
+     {
+         print(value, base);
+         println();
+     }
+     void printf(const char *format, ...)
+     {
+         va_list args;
+         va_start(args, format);
+         vprintf(format, args);
+         va_end(args);
+     }
+ };
+
+ static HostSerial Serial;
+
+ #endif
+
+ #endif // PN532_PLATFORM_H
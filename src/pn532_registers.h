@@ -0,0 +1,118 @@
+/**
+ * @file pn532_registers.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Shadow copy of the PN532 CIU registers written by the library
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_REGISTERS_H
+ #define PN532_REGISTERS_H
+
+ #include <stddef.h>
+ #include <stdint.h>
+
+ // Remembers what the reader holds in the registers the library writes and
+ // which writes are still to be sent. A write that matches the register is
+ // dropped, a later write to a pending register replaces the earlier one, and
+ // takePending() hands all pending writes out as one WriteRegister payload.
+ // Registers whose value is unknown, e.g. after a reconnect, are always written.
+ class PN532_RegisterCache {
+ public:
+     // Distinct registers tracked, and pending writes per WriteRegister frame
+     static const size_t CAPACITY = 8;
+
+     // Returns false if the write was not recorded because CAPACITY writes
+     // are already pending; take them first.
+     bool write(uint16_t address, uint8_t value)
+     {
+         Entry *known = find(_known, _knownCount, address);
+         Entry *pending = find(_pending, _pendingCount, address);
+         if (known && known->value == value)
+         {
+             if (pending)
+             {
+                 *pending = _pending[--_pendingCount];
+             }
+             return true;
+         }
+         if (pending)
+         {
+             pending->value = value;
+             return true;
+         }
+         if (_pendingCount == CAPACITY)
+         {
+             return false;
+         }
+         _pending[_pendingCount++] = {address, value};
+         return true;
+     }
+
+     bool hasPending() const { return _pendingCount > 0; }
+
+     // Writes the pending writes as address MSB, LSB, value triples and takes
+     // them as the register values from now on. Returns the payload length.
+     size_t takePending(uint8_t *payload)
+     {
+         size_t length = 0;
+         for (size_t i = 0; i < _pendingCount; i++)
+         {
+             payload[length++] = _pending[i].address >> 8;
+             payload[length++] = _pending[i].address & 0xFF;
+             payload[length++] = _pending[i].value;
+             remember(_pending[i].address, _pending[i].value);
+         }
+         _pendingCount = 0;
+         return length;
+     }
+
+     // Forgets the register values, pending writes are kept
+     void invalidate() { _knownCount = 0; }
+     void invalidate(uint16_t address)
+     {
+         Entry *known = find(_known, _knownCount, address);
+         if (known)
+         {
+             *known = _known[--_knownCount];
+         }
+     }
+
+ private:
+     typedef struct {
+         uint16_t address;
+         uint8_t value;
+     } Entry;
+
+     Entry _known[CAPACITY];
+     Entry _pending[CAPACITY];
+     size_t _knownCount = 0;
+     size_t _pendingCount = 0;
+
+     static Entry *find(Entry *entries, size_t count, uint16_t address)
+     {
+         for (size_t i = 0; i < count; i++)
+         {
+             if (entries[i].address == address)
+             {
+                 return &entries[i];
+             }
+         }
+         return nullptr;
+     }
+
+     void remember(uint16_t address, uint8_t value)
+     {
+         Entry *known = find(_known, _knownCount, address);
+         if (known)
+         {
+             known->value = value;
+         }
+         else if (_knownCount < CAPACITY)
+         {
+             _known[_knownCount++] = {address, value};
+         }
+     }
+ };
+
+ #endif // PN532_REGISTERS_H
@@ -0,0 +1,78 @@
+/**
+ * @file pn532_ring.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Bounded lock-free single-producer/single-consumer ring
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_RING_H
+ #define PN532_RING_H
+
+ #include <atomic>
+ #include <stddef.h>
+
+ // Slots are preallocated and filled in place: the producer (the BLE notify
+ // callback) acquire()s a slot, writes it and commit()s it; the consumer only
+ // sees it after commit, and the producer never reuses it before pop().
+ // Neither side allocates, locks or blocks.
+ template <typename T, size_t N> class PN532_SpscRing {
+     static_assert(N > 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+ public:
+     // Producer side. Returns nullptr when the ring is full.
+     T *acquire()
+     {
+         size_t head = _head.load(std::memory_order_relaxed);
+         if (head - _tail.load(std::memory_order_acquire) == N)
+         {
+             _dropped.fetch_add(1, std::memory_order_relaxed);
+             return nullptr;
+         }
+         return &_slots[head & (N - 1)];
+     }
+     void commit() { _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+     // Consumer side. Returns nullptr when the ring is empty.
+     T *front()
+     {
+         size_t tail = _tail.load(std::memory_order_relaxed);
+         if (tail == _head.load(std::memory_order_acquire))
+         {
+             return nullptr;
+         }
+         return &_slots[tail & (N - 1)];
+     }
+     // i-th committed item counted from front(), nullptr past the end
+     T *peek(size_t i)
+     {
+         size_t tail = _tail.load(std::memory_order_relaxed);
+         if (i >= _head.load(std::memory_order_acquire) - tail)
+         {
+             return nullptr;
+         }
+         return &_slots[(tail + i) & (N - 1)];
+     }
+     void pop() { _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+     void clear()
+     {
+         while (front())
+         {
+             pop();
+         }
+     }
+
+     bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+     size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+     static constexpr size_t capacity() { return N; }
+     // Items the producer had to drop because the ring was full
+     size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+ private:
+     T _slots[N];
+     std::atomic<size_t> _head{0};
+     std::atomic<size_t> _tail{0};
+     std::atomic<size_t> _dropped{0};
+ };
+
+ #endif // PN532_RING_H
@@ -0,0 +1,172 @@
+/**
+ * @file pn532_session.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief ISO14443A card session sharing one selection across probes
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_session.h"
+
+const uint8_t PN532_CardSession::DEFAULT_GEN4_PASSWORD[4] = {0x00, 0x00, 0x00, 0x00};
+
+bool PN532_CardSession::select()
+{
+    _tag = _nfc.hf14aScan();
+    _state = _tag.uid.empty() ? StateNone : StateActive;
+    return _state == StateActive;
+}
+
+bool PN532_CardSession::ensureSelected()
+{
+    switch (_state)
+    {
+    case StateActive:
+    case StateBackdoor:
+        return true;
+    case StateNone:
+        return select();
+    case StateHalted:
+        _reselects++;
+        return wakeHalted();
+    case StateIdle:
+    default:
+        break;
+    }
+
+    // InListPassiveTarget is a single round trip and registers the target
+    // with the firmware, so InDataExchange works afterwards
+    _reselects++;
+    PN532::Iso14aTagInfo tag = _nfc.hf14aScan();
+    _state = !tag.uid.empty() && tag.uid == _tag.uid ? StateActive : StateNone;
+    return _state == StateActive;
+}
+
+bool PN532_CardSession::wakeHalted()
+{
+    // REQA does not reach a halted card: WUPA, then SELECT with the cached
+    // UID, no anticollision needed
+    _state = StateNone;
+    rawMode();
+    std::vector<uint8_t> atqa = _nfc.send7bit({0x52});
+    if (atqa.size() != 3 || atqa[0] != 0x00)
+    {
+        return false;
+    }
+
+    const std::vector<uint8_t> &uid = _tag.uid;
+    bool cascade = uid.size() == 7;
+    if (uid.size() != 4 && !cascade)
+    {
+        return false;
+    }
+    for (int level = 0; level < (cascade ? 2 : 1); level++)
+    {
+        std::vector<uint8_t> select = {(uint8_t)(level == 0 ? 0x93 : 0x95), 0x70};
+        if (cascade && level == 0)
+        {
+            select.push_back(0x88); // cascade tag
+            select.insert(select.end(), uid.begin(), uid.begin() + 3);
+        }
+        else
+        {
+            select.insert(select.end(), uid.end() - 4, uid.end());
+        }
+        select.push_back(select[2] ^ select[3] ^ select[4] ^ select[5]);
+        // SAK and its CRC_A
+        std::vector<uint8_t> sak = _nfc.sendData(select, true);
+        if (sak.size() != 4 || sak[0] != 0x00)
+        {
+            return false;
+        }
+    }
+    _state = StateActive;
+    return true;
+}
+
+void PN532_CardSession::rawMode()
+{
+    // Probes append and check CRC_A themselves
+    _nfc.writeRegister(PN532::REG_TX_MODE, 0x00);
+    _nfc.writeRegister(PN532::REG_RX_MODE, 0x00);
+}
+
+bool PN532_CardSession::probeGen3()
+{
+    rawMode();
+    // READ block 0 without authenticating, status + 16 bytes + CRC_A
+    std::vector<uint8_t> result = _nfc.sendData({0x30, 0x00}, true);
+    if (result.size() == 19 && result[0] == 0x00)
+    {
+        return true;
+    }
+    _state = StateIdle;
+    return false;
+}
+
+bool PN532_CardSession::probeGen4(const uint8_t password[4])
+{
+    rawMode();
+    // Read the configuration, status + 30 bytes + CRC_A
+    std::vector<uint8_t> command = {0xCF, password[0], password[1], password[2], password[3], 0xC6};
+    std::vector<uint8_t> result = _nfc.sendData(command, true);
+    if (result.size() >= 15 && result[0] == 0x00)
+    {
+        return true;
+    }
+    _state = StateIdle;
+    return false;
+}
+
+bool PN532_CardSession::probeGen1A()
+{
+    rawMode();
+    // HLTA gets no answer, the backdoor only opens from HALT
+    _nfc.sendData({0x50, 0x00}, true);
+    _state = StateHalted;
+
+    std::vector<uint8_t> unlock1 = _nfc.send7bit({0x40});
+    if (unlock1.size() != 2 || unlock1[1] != 0x0A)
+    {
+        return false;
+    }
+    std::vector<uint8_t> unlock2 = _nfc.sendData({0x43}, false);
+    if (unlock2.size() != 2 || unlock2[1] != 0x0A)
+    {
+        // Woken up by the first half, the rest was not accepted
+        _state = StateIdle;
+        return false;
+    }
+    _state = StateBackdoor;
+    return true;
+}
+
+PN532_CardSession::Detection PN532_CardSession::detect(const uint8_t gen4Password[4])
+{
+    unsigned long startTime = millis();
+    Detection out = {};
+    _reselects = 0;
+
+    // Successful probes leave the card selected. A failed one drops it to
+    // idle, which a scan recovers in one round trip; only the Gen1A probe
+    // needs HALT, which takes a WUPA to leave, so it runs last.
+    if (isClassic() && ensureSelected())
+    {
+        out.probes++;
+        out.magic |= probeGen3() ? MagicGen3 : 0;
+    }
+    if (ensureSelected())
+    {
+        out.probes++;
+        out.magic |= probeGen4(gen4Password) ? MagicGen4 : 0;
+    }
+    if (ensureSelected())
+    {
+        out.probes++;
+        out.magic |= probeGen1A() ? MagicGen1A : 0;
+    }
+
+    out.reselects = _reselects;
+    out.elapsedMs = millis() - startTime;
+    return out;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file pn532_session.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief ISO14443A card session sharing one selection across probes
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_SESSION_H
+ #define PN532_SESSION_H
+
+ #include "pn532.h"
+
+ // Scans a card once, keeps its UID, ATQA and SAK, and tracks what state the
+ // card is in so it is only selected again when a probe knocked it out.
+ // detect() runs the Gen3, Gen4 and Gen1A probes in the order that needs the
+ // fewest reselects and reports all of them at once:
+ //     PN532_CardSession session(nfc);
+ //     if (session.select() && session.detect().magic & PN532_CardSession::MagicGen1A) { ... }
+ class PN532_CardSession {
+ public:
+     enum State {
+         StateNone,     // nothing selected yet, or the card is gone
+         StateActive,   // selected, ready for commands
+         StateIdle,     // a command failed, the card waits for REQA/WUPA
+         StateHalted,   // after HLTA, only WUPA wakes it
+         StateBackdoor, // Gen1A unlocked, raw reads and writes work on any block
+     };
+
+     // Bits of Detection::magic, 0 is a regular card
+     static const uint8_t MagicGen1A = 0x01; // 0x40/0x43 backdoor
+     static const uint8_t MagicGen3 = 0x02;  // block 0 readable without authentication
+     static const uint8_t MagicGen4 = 0x04;  // answers the Gen4 password command
+
+     typedef struct {
+         uint8_t magic;
+         uint8_t probes;    // probes sent
+         uint8_t reselects; // selections needed between them
+         unsigned long elapsedMs;
+     } Detection;
+
+     PN532_CardSession(PN532 &nfc) : _nfc(nfc) {}
+
+     // Scans for a card and caches what it reported. Returns false if none answered.
+     bool select();
+     // Brings the cached card back to StateActive, scanning only if needed
+     bool ensureSelected();
+     // Forgets the card, the next select() scans again
+     void reset() { _state = StateNone; }
+
+     State state() const { return _state; }
+     bool isSelected() const { return _state == StateActive || _state == StateBackdoor; }
+     const PN532::Iso14aTagInfo &tag() const { return _tag; }
+     bool isClassic() const { return (_tag.sak & 0x08) != 0; }
+
+     // Runs every probe once; the card is left halted, or unlocked for a Gen1A
+     Detection detect(const uint8_t gen4Password[4] = DEFAULT_GEN4_PASSWORD);
+
+     static const uint8_t DEFAULT_GEN4_PASSWORD[4];
+
+ private:
+     PN532 &_nfc;
+     PN532::Iso14aTagInfo _tag;
+     State _state = StateNone;
+     uint8_t _reselects = 0;
+
+     void rawMode();
+     bool probeGen3();
+     bool probeGen4(const uint8_t password[4]);
+     bool probeGen1A();
+     bool wakeHalted();
+ };
+
+ #endif // PN532_SESSION_H
@@ -0,0 +1,78 @@
+/**
+ * @file pn532_signal.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Wakes the task waiting for a response from the transport receive path
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_SIGNAL_H
+ #define PN532_SIGNAL_H
+
+ #include "pn532_platform.h"
+
+ #if defined(ESP_PLATFORM)
+ #include <freertos/FreeRTOS.h>
+ #include <freertos/semphr.h>
+ #elif !defined(ARDUINO)
+ #include <chrono>
+ #include <condition_variable>
+ #include <mutex>
+ #endif
+
+ // Binary event: notify() never blocks and may be called from the NimBLE
+ // host task, wait() returns as soon as a notify() happened since the last
+ // wait() or the timeout expired.
+ class PN532_Signal {
+ public:
+ #if defined(ESP_PLATFORM)
+     PN532_Signal() { _sem = xSemaphoreCreateBinaryStatic(&_buffer); }
+     ~PN532_Signal() { vSemaphoreDelete(_sem); }
+     void notify() { xSemaphoreGive(_sem); }
+     bool wait(uint32_t timeoutMs) { return xSemaphoreTake(_sem, pdMS_TO_TICKS(timeoutMs)) == pdTRUE; }
+
+ private:
+     StaticSemaphore_t _buffer;
+     SemaphoreHandle_t _sem;
+ #elif !defined(ARDUINO)
+     void notify()
+     {
+         {
+             std::lock_guard<std::mutex> lock(_mutex);
+             _set = true;
+         }
+         _cv.notify_one();
+     }
+     bool wait(uint32_t timeoutMs)
+     {
+         std::unique_lock<std::mutex> lock(_mutex);
+         bool set = _cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return _set; });
+         _set = false;
+         return set;
+     }
+
+ private:
+     std::mutex _mutex;
+     std::condition_variable _cv;
+     bool _set = false;
+ #else
+     // No RTOS primitives available, fall back to a short poll
+     void notify() { _set = true; }
+     bool wait(uint32_t timeoutMs)
+     {
+         unsigned long start = millis();
+         while (!_set && millis() - start < timeoutMs)
+         {
+             delay(1);
+         }
+         bool set = _set;
+         _set = false;
+         return set;
+     }
+
+ private:
+     volatile bool _set = false;
+ #endif
+ };
+
+ #endif // PN532_SIGNAL_H
@@ -0,0 +1,917 @@
+/**
+ * @file pn532_sim.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief In-process simulated PN532 reader for host builds, profiling and regression runs
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_sim.h"
+#include "pn532_frame.h"
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+    const uint8_t ACK_FRAME[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+    const uint8_t ERROR_FRAME[] = {0x00, 0x00, 0xFF, 0x01, 0xFF, 0x7F, 0x81, 0x00};
+
+    // PN532 status bytes
+    const uint8_t STATUS_OK = 0x00;
+    const uint8_t STATUS_TIMEOUT = 0x01;
+    const uint8_t STATUS_COLLISION = 0x06;
+    const uint8_t STATUS_MIFARE_ERROR = 0x14;
+    const uint8_t STATUS_WRONG_CONTEXT = 0x27;
+
+    int classicSector(uint8_t block) { return block < 128 ? block / 4 : 32 + (block - 128) / 16; }
+
+    int classicTrailer(int sector) { return sector < 32 ? sector * 4 + 3 : 128 + (sector - 32) * 16 + 15; }
+}
+
+PN532_Simulator::PN532_Simulator() : PN532_Simulator(Config()) {}
+
+PN532_Simulator::PN532_Simulator(const Config &config) : _config(config)
+{
+    _lastDue = std::chrono::steady_clock::now();
+    _worker = std::thread(&PN532_Simulator::run, this);
+}
+
+PN532_Simulator::~PN532_Simulator()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _worker.join();
+}
+
+void PN532_Simulator::setConfig(const Config &config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _config = config;
+}
+
+PN532_Simulator::Config PN532_Simulator::getConfig()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config;
+}
+
+void PN532_Simulator::setIso14aCard(const Iso14aCard &card)
+{
+    _hf14a = card;
+    _hf14aPresent = true;
+    _state = TagIdle;
+    _authSector = -1;
+    _backdoor = 0;
+}
+
+void PN532_Simulator::setIso15Card(const Iso15Card &card)
+{
+    _hf15 = card;
+    _hf15Present = true;
+}
+
+void PN532_Simulator::addIso15Card(const Iso15Card &card)
+{
+    if (!_hf15Present)
+    {
+        setIso15Card(card);
+        return;
+    }
+    _hf15Others.push_back(card);
+}
+
+void PN532_Simulator::setLfCard(const LfCard &card)
+{
+    _lf = card;
+    _lfPresent = true;
+}
+
+void PN532_Simulator::removeCards()
+{
+    _hf14aPresent = false;
+    _hf15Present = false;
+    _hf15Others.clear();
+    _lfPresent = false;
+    _target = TargetNone;
+}
+
+PN532_Simulator::Iso14aCard PN532_Simulator::mifareClassic1K(const std::vector<uint8_t> &uid)
+{
+    Iso14aCard card;
+    card.uid = uid;
+    card.atqa = {0x00, 0x04};
+    card.sak = 0x08;
+    card.memory.assign(1024, 0x00);
+    for (int sector = 0; sector < 16; sector++)
+    {
+        uint8_t *trailer = card.memory.data() + classicTrailer(sector) * 16;
+        memset(trailer, 0xFF, 6);
+        trailer[6] = 0xFF;
+        trailer[7] = 0x07;
+        trailer[8] = 0x80;
+        trailer[9] = 0x69;
+        memset(trailer + 10, 0xFF, 6);
+    }
+    // Manufacturer block: UID, BCC, SAK, ATQA
+    uint8_t bcc = 0;
+    for (size_t i = 0; i < uid.size() && i < 4; i++)
+    {
+        card.memory[i] = uid[i];
+        bcc ^= uid[i];
+    }
+    card.memory[4] = bcc;
+    card.memory[5] = card.sak;
+    card.memory[6] = card.atqa[1];
+    card.memory[7] = card.atqa[0];
+    return card;
+}
+
+PN532_Simulator::Iso14aCard PN532_Simulator::mifareUltralight(const std::vector<uint8_t> &uid, size_t pages)
+{
+    Iso14aCard card;
+    card.uid = uid;
+    card.atqa = {0x00, 0x44};
+    card.sak = 0x00;
+    card.memory.assign(pages * 4, 0x00);
+    for (size_t i = 0; i < 3 && i < uid.size(); i++)
+    {
+        card.memory[i] = uid[i];
+    }
+    card.memory[3] = 0x88 ^ card.memory[0] ^ card.memory[1] ^ card.memory[2];
+    for (size_t i = 3; i < 7 && i < uid.size(); i++)
+    {
+        card.memory[i + 1] = uid[i];
+    }
+    card.memory[8] = card.memory[4] ^ card.memory[5] ^ card.memory[6] ^ card.memory[7];
+    return card;
+}
+
+PN532_Simulator::Iso14aCard PN532_Simulator::ntag(const std::vector<uint8_t> &uid, size_t pages)
+{
+    Iso14aCard card = mifareUltralight(uid, pages);
+    uint8_t storage = pages <= 45 ? 0x0F : pages <= 135 ? 0x11 : 0x13;
+    card.version = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, storage, 0x03};
+    return card;
+}
+
+PN532_Simulator::Iso15Card
+PN532_Simulator::iso15693(const std::vector<uint8_t> &uid, uint8_t blockSize, uint16_t blockCount)
+{
+    Iso15Card card;
+    card.uid = uid;
+    card.dsfid = 0x00;
+    card.afi = 0x00;
+    card.icRef = 0x01;
+    card.blockSize = blockSize;
+    card.blockCount = blockCount;
+    card.multiBlockLimit = 32;
+    card.memory.assign(blockSize * blockCount, 0x00);
+    return card;
+}
+
+PN532_Simulator::Stats PN532_Simulator::getStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void PN532_Simulator::resetStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats = {};
+}
+
+void PN532_Simulator::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return _pending.empty(); });
+}
+
+bool PN532_Simulator::write(const uint8_t *data, size_t length)
+{
+    if (!_connected)
+    {
+        return false;
+    }
+
+    _input.insert(_input.end(), data, data + length);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.bytesReceived += length;
+    }
+
+    // Extract every complete host frame, skipping wakeup bytes and garbage
+    size_t pos = 0;
+    while (_input.size() - pos >= 6)
+    {
+        if (_input[pos] != 0x00 || _input[pos + 1] != 0x00 || _input[pos + 2] != 0xFF)
+        {
+            pos++;
+            continue;
+        }
+        size_t header = 5;
+        size_t len = _input[pos + 3];
+        uint8_t lcs = _input[pos + 4];
+        bool valid = ((len + lcs) & 0xFF) == 0x00;
+        if (len == 0xFF && lcs == 0xFF)
+        {
+            // Extended frame: FF FF LENM LENL LCS
+            if (_input.size() - pos < 8)
+            {
+                break;
+            }
+            header = 8;
+            len = (_input[pos + 5] << 8) | _input[pos + 6];
+            valid = ((_input[pos + 5] + _input[pos + 6] + _input[pos + 7]) & 0xFF) == 0x00;
+        }
+        if (!valid || len < 2)
+        {
+            pos++;
+            continue;
+        }
+        if (_input.size() - pos < header + len + 2)
+        {
+            break;
+        }
+
+        const uint8_t *body = _input.data() + pos + header;
+        uint8_t sum = 0;
+        for (size_t i = 0; i <= len; i++)
+        {
+            sum += body[i];
+        }
+        if (sum == 0x00 && body[0] == 0xD4)
+        {
+            processFrame(body[1], body + 2, len - 2);
+        }
+        else
+        {
+            std::vector<uint8_t> reply(ACK_FRAME, ACK_FRAME + sizeof(ACK_FRAME));
+            reply.insert(reply.end(), ERROR_FRAME, ERROR_FRAME + sizeof(ERROR_FRAME));
+            schedule(reply);
+        }
+        pos += header + len + 2;
+    }
+    _input.erase(_input.begin(), _input.begin() + pos);
+    return true;
+}
+
+void PN532_Simulator::processFrame(uint8_t command, const uint8_t *data, size_t length)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.framesReceived++;
+    }
+
+    std::vector<uint8_t> reply(ACK_FRAME, ACK_FRAME + sizeof(ACK_FRAME));
+    std::vector<uint8_t> payload;
+    bool handled = (_handler && _handler(command, data, length, payload)) ||
+                   handleCommand(command, data, length, payload);
+    if (!handled)
+    {
+        reply.insert(reply.end(), ERROR_FRAME, ERROR_FRAME + sizeof(ERROR_FRAME));
+        schedule(reply);
+        return;
+    }
+
+    uint8_t frame[PN532_FrameEncoder::MAX_FRAME_SIZE];
+    size_t frameLength = PN532_FrameEncoder::encode(frame, sizeof(frame), 0xD5, command + 1, payload.data(), payload.size());
+    if (frameLength == 0)
+    {
+        reply.insert(reply.end(), ERROR_FRAME, ERROR_FRAME + sizeof(ERROR_FRAME));
+    }
+    reply.insert(reply.end(), frame, frame + frameLength);
+    schedule(reply);
+}
+
+void PN532_Simulator::schedule(const std::vector<uint8_t> &reply)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t chunk = _config.mtu > 3 ? _config.mtu - 3 : 1;
+    auto due = std::max(std::chrono::steady_clock::now() + std::chrono::microseconds(_config.latencyUs), _lastDue);
+
+    size_t offset = 0;
+    size_t ackEnd = _config.splitAck ? sizeof(ACK_FRAME) : 0;
+    while (offset < reply.size())
+    {
+        size_t end = std::min(reply.size(), offset + chunk);
+        if (offset < ackEnd && end > ackEnd)
+        {
+            end = ackEnd;
+        }
+        Notification notification;
+        notification.due = due;
+        notification.bytes.assign(reply.begin() + offset, reply.begin() + end);
+        _pending.push_back(notification);
+        offset = end;
+        due += std::chrono::microseconds(_config.fragmentGapUs);
+    }
+    _lastDue = due;
+    _cv.notify_all();
+}
+
+void PN532_Simulator::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        if (_stop)
+        {
+            return;
+        }
+        if (_pending.empty())
+        {
+            _idle.notify_all();
+            _cv.wait(lock);
+            continue;
+        }
+        auto due = _pending.front().due;
+        if (std::chrono::steady_clock::now() < due)
+        {
+            _cv.wait_until(lock, due);
+            continue;
+        }
+
+        Notification notification = std::move(_pending.front());
+        _pending.pop_front();
+        _stats.notificationsSent++;
+        _stats.bytesSent += notification.bytes.size();
+        lock.unlock();
+        receive(notification.bytes.data(), notification.bytes.size());
+        lock.lock();
+    }
+}
+
+bool PN532_Simulator::handleCommand(uint8_t command, const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    switch (command)
+    {
+    case 0x00: // Diagnose
+        response.assign(data, data + length);
+        return true;
+    case 0x02: // GetFirmwareVersion
+        response = {0x32, 0x01, 0x06, 0x07};
+        return true;
+    case 0x06: // ReadRegister
+        for (size_t i = 0; i + 1 < length; i += 2)
+        {
+            response.push_back(_registers[(data[i] << 8) | data[i + 1]]);
+        }
+        return true;
+    case 0x08: // WriteRegister
+        for (size_t i = 0; i + 2 < length; i += 3)
+        {
+            _registers[(data[i] << 8) | data[i + 1]] = data[i + 2];
+        }
+        return true;
+    case 0x14: // SAMConfiguration
+        return true;
+    case 0x16: // PowerDown
+        response = {STATUS_OK};
+        return true;
+    case 0x40: // InDataExchange
+        dataExchange(data, length, response);
+        return true;
+    case 0x42: // InCommunicateThru
+        communicateThru(data, length, response);
+        return true;
+    case 0x44: // InDeselect
+    case 0x52: // InRelease
+        _target = TargetNone;
+        _state = TagIdle;
+        _authSector = -1;
+        response = {STATUS_OK};
+        return true;
+    case 0x54: // InSelect
+        response = {STATUS_OK};
+        return true;
+    case 0x4A: // InListPassiveTarget
+        listPassiveTarget(data, length, response);
+        return true;
+    case 0x60: // InAutoPoll
+        autoPoll(data, length, response);
+        return true;
+    case 0x8C: // TgInitAsTarget
+    case 0x86: // TgGetData
+    case 0x8E: // TgSetData
+        response = {STATUS_OK};
+        return true;
+    default:
+        return false;
+    }
+}
+
+void PN532_Simulator::autoPoll(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    // Answers right away instead of after PollNr periods; only ISO14443A
+    // cards are simulated, reported as the first matching type requested
+    response = {0x00};
+    if (length < 3 || !_hf14aPresent)
+    {
+        return;
+    }
+    for (size_t i = 2; i < length; i++)
+    {
+        if (data[i] == 0x00 || data[i] == 0x10 || data[i] == 0x20)
+        {
+            _target = TargetIso14a;
+            _state = TagActive;
+            _authSector = -1;
+            _backdoor = 0;
+            response = {0x01, data[i] == 0x20 ? (uint8_t)0x10 : data[i]};
+            response.push_back(5 + _hf14a.uid.size());
+            response.insert(response.end(), {0x01, _hf14a.atqa[0], _hf14a.atqa[1], _hf14a.sak});
+            response.push_back(_hf14a.uid.size());
+            response.insert(response.end(), _hf14a.uid.begin(), _hf14a.uid.end());
+            return;
+        }
+    }
+}
+
+void PN532_Simulator::listPassiveTarget(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    uint8_t brTy = length > 1 ? data[1] : 0x00;
+    _target = TargetNone;
+
+    if (brTy == 0x00 && _hf14aPresent)
+    {
+        _target = TargetIso14a;
+        _state = TagActive;
+        _authSector = -1;
+        _backdoor = 0;
+        response = {0x01, 0x01, _hf14a.atqa[0], _hf14a.atqa[1], _hf14a.sak, (uint8_t)_hf14a.uid.size()};
+        response.insert(response.end(), _hf14a.uid.begin(), _hf14a.uid.end());
+    }
+    else if (brTy == 0x05 && _hf15Present)
+    {
+        _target = TargetIso15;
+        response = {0x01, 0x01};
+        response.insert(response.end(), _hf15.uid.rbegin(), _hf15.uid.rend());
+    }
+    else if (brTy == 0x06 && _lfPresent)
+    {
+        _target = TargetLf;
+        response = {0x01, 0x01};
+        response.insert(response.end(), _lf.uid.begin(), _lf.uid.end());
+    }
+    else
+    {
+        response = {0x00};
+    }
+}
+
+void PN532_Simulator::dataExchange(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    if (length < 2 || _target == TargetNone || _target == TargetLf)
+    {
+        response = {STATUS_WRONG_CONTEXT};
+        return;
+    }
+
+    if (_target == TargetIso15)
+    {
+        uint8_t block = length > 2 ? data[2] : 0;
+        if (block >= _hf15.blockCount)
+        {
+            response = {STATUS_OK, 0x01, 0x10};
+            return;
+        }
+        uint8_t *mem = _hf15.memory.data() + block * _hf15.blockSize;
+        if (data[1] == 0x20)
+        {
+            response = {STATUS_OK, 0x00};
+            response.insert(response.end(), mem, mem + _hf15.blockSize);
+            return;
+        }
+        if (data[1] == 0x21 && length >= 3u + _hf15.blockSize)
+        {
+            memcpy(mem, data + 3, _hf15.blockSize);
+            response = {STATUS_OK, 0x00};
+            return;
+        }
+        response = {STATUS_OK, 0x01, 0x01};
+        return;
+    }
+
+    if (_state != TagActive)
+    {
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+    mifareCommand(data + 1, length - 1, response);
+}
+
+void PN532_Simulator::mifareCommand(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    switch (data[0])
+    {
+    case 0x60:
+    case 0x61:
+        if (length < 12 || !mifareAuth(data[1], data + 2, data[0] == 0x60, data + 8))
+        {
+            // A failed authentication drops the card back to idle
+            _state = TagIdle;
+            _authSector = -1;
+            response = {STATUS_MIFARE_ERROR};
+            return;
+        }
+        response = {STATUS_OK};
+        return;
+    case 0x30:
+        if (length < 2 || (!isUltralight() && _backdoor < 2 && classicSector(data[1]) != _authSector))
+        {
+            response = {STATUS_MIFARE_ERROR};
+            return;
+        }
+        response = {STATUS_OK};
+        readBlocks(data[1], response);
+        return;
+    case 0xA0:
+        if (length < 18 || isUltralight() || (_backdoor < 2 && classicSector(data[1]) != _authSector) ||
+            !writeBlock(data[1], data + 2, 16))
+        {
+            response = {STATUS_MIFARE_ERROR};
+            return;
+        }
+        response = {STATUS_OK};
+        return;
+    case 0xA2:
+        if (length < 6 || !isUltralight() || !writeBlock(data[1], data + 2, 4))
+        {
+            response = {STATUS_MIFARE_ERROR};
+            return;
+        }
+        response = {STATUS_OK};
+        return;
+    default:
+        response = {STATUS_MIFARE_ERROR};
+        return;
+    }
+}
+
+void PN532_Simulator::communicateThru(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    if (_target == TargetIso15)
+    {
+        iso15Command(data, length, response);
+        return;
+    }
+    if (!_hf14aPresent || length == 0)
+    {
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    uint8_t lastBits = _registers[0x633D] & 0x07;
+    if (lastBits == 7 && length == 1)
+    {
+        switch (data[0])
+        {
+        case 0x26: // REQA
+        case 0x52: // WUPA
+            if (data[0] == 0x26 && _state == TagHalted)
+            {
+                response = {STATUS_TIMEOUT};
+                return;
+            }
+            _state = TagReady;
+            _authSector = -1;
+            response = {STATUS_OK, _hf14a.atqa[1], _hf14a.atqa[0]};
+            return;
+        case 0x40: // Gen1A unlock, first half
+            if (_hf14a.magic == MagicGen1A && _state == TagHalted)
+            {
+                _backdoor = 1;
+                response = {STATUS_OK, 0x0A};
+                return;
+            }
+            break;
+        }
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    if (data[0] == 0x43 && length == 1 && _backdoor == 1)
+    {
+        _backdoor = 2;
+        _state = TagActive;
+        response = {STATUS_OK, 0x0A};
+        return;
+    }
+
+    if (data[0] == 0x50) // HLTA, the card never answers
+    {
+        _state = TagHalted;
+        _authSector = -1;
+        _backdoor = 0;
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    if ((data[0] == 0x93 || data[0] == 0x95) && length >= 2)
+    {
+        bool cascade = _hf14a.uid.size() > 4;
+        bool level2 = data[0] == 0x95;
+        uint8_t part[5];
+        if (!cascade)
+        {
+            memcpy(part, _hf14a.uid.data(), 4);
+        }
+        else if (!level2)
+        {
+            part[0] = 0x88;
+            memcpy(part + 1, _hf14a.uid.data(), 3);
+        }
+        else
+        {
+            memcpy(part, _hf14a.uid.data() + 3, 4);
+        }
+        part[4] = part[0] ^ part[1] ^ part[2] ^ part[3];
+
+        if (_state != TagReady || (level2 && !cascade))
+        {
+            response = {STATUS_TIMEOUT};
+            return;
+        }
+        if (data[1] == 0x20)
+        {
+            response = {STATUS_OK};
+            response.insert(response.end(), part, part + 5);
+            return;
+        }
+        if (data[1] == 0x70 && length >= 9 && memcmp(data + 2, part, 5) == 0 && crcA(data, length) == 0)
+        {
+            uint8_t sak = (cascade && !level2) ? 0x04 : _hf14a.sak;
+            if (sak != 0x04)
+            {
+                _state = TagActive;
+            }
+            uint16_t crc = crcA(&sak, 1);
+            response = {STATUS_OK, sak, (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8)};
+            return;
+        }
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    if (_state != TagActive || length < 3 || crcA(data, length) != 0)
+    {
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    // Ultralight refuses a READ that starts past its last page
+    if (data[0] == 0x30 && ((isUltralight() && data[1] < _hf14a.memory.size() / 4) || _hf14a.magic == MagicGen3 ||
+                            _backdoor == 2))
+    {
+        std::vector<uint8_t> blocks;
+        readBlocks(data[1], blocks);
+        uint16_t crc = crcA(blocks.data(), blocks.size());
+        response = {STATUS_OK};
+        response.insert(response.end(), blocks.begin(), blocks.end());
+        response.push_back(crc & 0xFF);
+        response.push_back(crc >> 8);
+        return;
+    }
+
+    if (data[0] == 0x60 && length == 3 && !_hf14a.version.empty()) // GET_VERSION
+    {
+        uint16_t crc = crcA(_hf14a.version.data(), _hf14a.version.size());
+        response = {STATUS_OK};
+        response.insert(response.end(), _hf14a.version.begin(), _hf14a.version.end());
+        response.push_back(crc & 0xFF);
+        response.push_back(crc >> 8);
+        return;
+    }
+
+    // FAST_READ, only cards with GET_VERSION know it
+    if (data[0] == 0x3A && length == 5 && isUltralight() && !_hf14a.version.empty() && data[1] <= data[2] &&
+        (size_t)(data[2] + 1) * 4 <= _hf14a.memory.size())
+    {
+        const uint8_t *first = _hf14a.memory.data() + data[1] * 4;
+        const uint8_t *last = _hf14a.memory.data() + (data[2] + 1) * 4;
+        uint16_t crc = crcA(first, last - first);
+        response = {STATUS_OK};
+        response.insert(response.end(), first, last);
+        response.push_back(crc & 0xFF);
+        response.push_back(crc >> 8);
+        return;
+    }
+
+    if (data[0] == 0xA2 && length == 8 && isUltralight() && data[1] >= 2 && writeBlock(data[1], data + 2, 4))
+    {
+        response = {STATUS_OK, 0x0A};
+        return;
+    }
+
+    if (data[0] == 0xCF && _hf14a.magic == MagicGen4 && length >= 8 &&
+        std::equal(_hf14a.gen4Password.begin(), _hf14a.gen4Password.end(), data + 1) && data[5] == 0xC6)
+    {
+        std::vector<uint8_t> config(30, 0x00);
+        uint16_t crc = crcA(config.data(), config.size());
+        response = {STATUS_OK};
+        response.insert(response.end(), config.begin(), config.end());
+        response.push_back(crc & 0xFF);
+        response.push_back(crc >> 8);
+        return;
+    }
+
+    // A command the card does not accept sends it back to idle
+    _state = TagIdle;
+    _backdoor = 0;
+    response = {STATUS_TIMEOUT};
+}
+
+void PN532_Simulator::iso15Command(const uint8_t *data, size_t length, std::vector<uint8_t> &response)
+{
+    // req ack, tag number, flags, command, parameters..., CRC
+    if (!_hf15Present || length < 6 || crc16Ccitt(data + 2, length - 2) != 0xF0B8)
+    {
+        response = {STATUS_TIMEOUT};
+        return;
+    }
+
+    std::vector<uint8_t> reply;
+    uint8_t command = data[3];
+    if (command == 0x01) // Inventory
+    {
+        uint8_t status = iso15Inventory(data, length, reply);
+        if (status != STATUS_OK)
+        {
+            response = {status};
+            return;
+        }
+    }
+    else if (command == 0x2B) // Get System Information
+    {
+        reply = {0x00, 0x0F};
+        reply.insert(reply.end(), _hf15.uid.rbegin(), _hf15.uid.rend());
+        reply.push_back(_hf15.dsfid);
+        reply.push_back(_hf15.afi);
+        reply.push_back(_hf15.blockCount - 1);
+        reply.push_back(_hf15.blockSize - 1);
+        reply.push_back(_hf15.icRef);
+    }
+    else if (command == 0x20 && length >= 7 && data[4] < _hf15.blockCount) // Read Single Block
+    {
+        uint8_t *mem = _hf15.memory.data() + data[4] * _hf15.blockSize;
+        reply = {0x00};
+        reply.insert(reply.end(), mem, mem + _hf15.blockSize);
+    }
+    else if (command == 0x21 && length >= 7u + _hf15.blockSize && data[4] < _hf15.blockCount) // Write Single Block
+    {
+        memcpy(_hf15.memory.data() + data[4] * _hf15.blockSize, data + 5, _hf15.blockSize);
+        reply = {0x00};
+    }
+    else if (command == 0x23 && length >= 8 && data[5] < _hf15.multiBlockLimit &&
+             data[4] + data[5] < _hf15.blockCount) // Read Multiple Blocks
+    {
+        uint8_t *mem = _hf15.memory.data() + data[4] * _hf15.blockSize;
+        reply = {0x00};
+        reply.insert(reply.end(), mem, mem + (data[5] + 1) * _hf15.blockSize);
+    }
+    else if (command == 0x24 && length >= 8 && data[5] < _hf15.multiBlockLimit &&
+             data[4] + data[5] < _hf15.blockCount &&
+             length == 8u + (data[5] + 1) * _hf15.blockSize) // Write Multiple Blocks
+    {
+        memcpy(_hf15.memory.data() + data[4] * _hf15.blockSize, data + 6, (data[5] + 1) * _hf15.blockSize);
+        reply = {0x00};
+    }
+    else
+    {
+        reply = {0x01, 0x01};
+    }
+
+    uint16_t crc = crc16Ccitt(reply.data(), reply.size()) ^ 0xFFFF;
+    response = {STATUS_OK};
+    response.insert(response.end(), reply.begin(), reply.end());
+    response.push_back(crc & 0xFF);
+    response.push_back(crc >> 8);
+}
+
+uint8_t PN532_Simulator::iso15Inventory(const uint8_t *data, size_t length, std::vector<uint8_t> &reply)
+{
+    // req ack, tag number, flags, 0x01, mask length, mask LSB first, CRC.
+    // Only one slot inventories without AFI; the tags whose UID ends in the
+    // mask answer.
+    uint8_t maskBits = data[4];
+    size_t maskBytes = (maskBits + 7) / 8;
+    if (!(data[2] & 0x04) || (data[2] & 0x30) != 0x20 || maskBits > 64 || length != 7 + maskBytes)
+    {
+        reply = {0x01, 0x0F};
+        return STATUS_OK;
+    }
+
+    const Iso15Card *match = nullptr;
+    size_t matches = 0;
+    std::vector<const Iso15Card *> cards = {&_hf15};
+    for (const Iso15Card &card : _hf15Others)
+    {
+        cards.push_back(&card);
+    }
+    for (const Iso15Card *card : cards)
+    {
+        bool matched = card->uid.size() == 8;
+        for (uint8_t bit = 0; matched && bit < maskBits; bit++)
+        {
+            uint8_t uidByte = card->uid[7 - bit / 8];
+            matched = ((uidByte ^ data[5 + bit / 8]) >> (bit % 8) & 0x01) == 0;
+        }
+        if (matched)
+        {
+            match = card;
+            matches++;
+        }
+    }
+
+    if (matches != 1)
+    {
+        // Overlapping answers garble into a collision
+        return matches == 0 ? STATUS_TIMEOUT : STATUS_COLLISION;
+    }
+    reply = {0x00, match->dsfid};
+    reply.insert(reply.end(), match->uid.rbegin(), match->uid.rend());
+    return STATUS_OK;
+}
+
+bool PN532_Simulator::mifareAuth(uint8_t block, const uint8_t *key, bool keyA, const uint8_t *uid)
+{
+    if (isUltralight() || (size_t)(block + 1) * 16 > _hf14a.memory.size())
+    {
+        return false;
+    }
+    if (memcmp(uid, _hf14a.uid.data() + _hf14a.uid.size() - 4, 4) != 0)
+    {
+        return false;
+    }
+    int sector = classicSector(block);
+    const uint8_t *trailer = _hf14a.memory.data() + classicTrailer(sector) * 16;
+    if (memcmp(key, keyA ? trailer : trailer + 10, 6) != 0)
+    {
+        return false;
+    }
+    _authSector = sector;
+    return true;
+}
+
+void PN532_Simulator::readBlocks(uint8_t block, std::vector<uint8_t> &out)
+{
+    if (isUltralight())
+    {
+        // READ returns four pages and rolls over at the end of memory
+        size_t pages = _hf14a.memory.size() / 4;
+        for (size_t i = 0; i < 4; i++)
+        {
+            const uint8_t *page = _hf14a.memory.data() + ((block + i) % pages) * 4;
+            out.insert(out.end(), page, page + 4);
+        }
+        return;
+    }
+    size_t offset = (size_t)block * 16;
+    if (offset + 16 > _hf14a.memory.size())
+    {
+        out.insert(out.end(), 16, 0x00);
+        return;
+    }
+    out.insert(out.end(), _hf14a.memory.begin() + offset, _hf14a.memory.begin() + offset + 16);
+}
+
+bool PN532_Simulator::writeBlock(uint8_t block, const uint8_t *data, size_t length)
+{
+    size_t offset = (size_t)block * length;
+    if (offset + length > _hf14a.memory.size())
+    {
+        return false;
+    }
+    memcpy(_hf14a.memory.data() + offset, data, length);
+    return true;
+}
+
+uint16_t PN532_Simulator::crcA(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0x6363;
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t ch = data[i] ^ (crc & 0xFF);
+        ch = (ch ^ (ch << 4)) & 0xFF;
+        crc = (crc >> 8) ^ (ch << 8) ^ (ch << 3) ^ (ch >> 4);
+    }
+    return crc;
+}
+
+uint16_t PN532_Simulator::crc16Ccitt(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file pn532_sim.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief In-process simulated PN532 reader for host builds, profiling and regression runs
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_SIM_H
+ #define PN532_SIM_H
+
+ #include "pn532_transport.h"
+ #include <array>
+ #include <chrono>
+ #include <condition_variable>
+ #include <deque>
+ #include <map>
+ #include <mutex>
+ #include <thread>
+ #include <vector>
+
+ // Behaves like a PN532 BLE bridge: every command frame written to it is
+ // answered with an ACK frame plus the response frame, delivered from a
+ // background thread as MTU sized notifications after the configured latency.
+ class PN532_Simulator : public PN532_Transport {
+ public:
+     struct Config {
+         uint32_t latencyUs = 0;      // write to first notification of the reply
+         uint32_t fragmentGapUs = 0;  // between two notifications of the same reply
+         uint16_t mtu = 23;           // ATT MTU, each notification carries mtu - 3 bytes
+         bool splitAck = false;       // send the ACK frame in its own notification
+     };
+
+     enum Magic {
+         MagicNone,
+         MagicGen1A,
+         MagicGen3,
+         MagicGen4,
+     };
+
+     struct Iso14aCard {
+         std::vector<uint8_t> uid;
+         std::array<uint8_t, 2> atqa;
+         uint8_t sak;
+         std::vector<uint8_t> memory; // 16 byte blocks for Classic, 4 byte pages for Ultralight
+         Magic magic = MagicNone;
+         std::vector<uint8_t> gen4Password;
+         std::vector<uint8_t> version; // GET_VERSION reply, empty if the card has none
+     };
+
+     typedef struct {
+         std::vector<uint8_t> uid; // MSB first, as displayed
+         uint8_t dsfid;
+         uint8_t afi;
+         uint8_t icRef;
+         uint8_t blockSize;
+         uint16_t blockCount;
+         uint16_t multiBlockLimit; // blocks per Read/Write Multiple Blocks, 0 if not supported
+         std::vector<uint8_t> memory;
+     } Iso15Card;
+
+     typedef struct {
+         std::vector<uint8_t> uid;
+     } LfCard;
+
+     typedef struct {
+         uint32_t framesReceived;
+         uint32_t bytesReceived;
+         uint32_t notificationsSent;
+         uint32_t bytesSent;
+     } Stats;
+
+     // Return true when the command was handled and response holds the
+     // payload that follows the response code.
+     typedef std::function<bool(uint8_t command, const uint8_t *data, size_t length, std::vector<uint8_t> &response)>
+         CommandHandler;
+
+     PN532_Simulator();
+     PN532_Simulator(const Config &config);
+     ~PN532_Simulator();
+
+     bool isConnected() override { return _connected; }
+     bool write(const uint8_t *data, size_t length) override;
+
+     void setConnected(bool connected) { _connected = connected; }
+     void setConfig(const Config &config);
+     Config getConfig();
+     void setCommandHandler(CommandHandler handler) { _handler = handler; }
+
+     void setIso14aCard(const Iso14aCard &card);
+     void setIso15Card(const Iso15Card &card);
+     // Puts another ISO15693 tag in the field; only inventories see it
+     // alongside the first, other commands go to iso15Card()
+     void addIso15Card(const Iso15Card &card);
+     void setLfCard(const LfCard &card);
+     void removeCards();
+     Iso14aCard &iso14aCard() { return _hf14a; }
+     Iso15Card &iso15Card() { return _hf15; }
+
+     static Iso14aCard mifareClassic1K(const std::vector<uint8_t> &uid);
+     static Iso14aCard mifareUltralight(const std::vector<uint8_t> &uid, size_t pages = 16);
+     // NTAG213/215/216 for 45/135/231 pages, with GET_VERSION and FAST_READ
+     static Iso14aCard ntag(const std::vector<uint8_t> &uid, size_t pages = 231);
+     static Iso15Card iso15693(const std::vector<uint8_t> &uid, uint8_t blockSize = 4, uint16_t blockCount = 28);
+
+     Stats getStats();
+     void resetStats();
+     // Blocks until every scheduled notification has been delivered.
+     void flush();
+
+ private:
+     enum TagState {
+         TagIdle,
+         TagReady,
+         TagActive,
+         TagHalted,
+     };
+
+     enum Target {
+         TargetNone,
+         TargetIso14a,
+         TargetIso15,
+         TargetLf,
+     };
+
+     typedef struct {
+         std::chrono::steady_clock::time_point due;
+         std::vector<uint8_t> bytes;
+     } Notification;
+
+     Config _config;
+     bool _connected = true;
+     CommandHandler _handler;
+
+     bool _hf14aPresent = false;
+     bool _hf15Present = false;
+     bool _lfPresent = false;
+     Iso14aCard _hf14a;
+     Iso15Card _hf15;
+     std::vector<Iso15Card> _hf15Others;
+     LfCard _lf;
+
+     TagState _state = TagIdle;
+     Target _target = TargetNone;
+     int _authSector = -1;
+     uint8_t _backdoor = 0;
+     std::map<uint16_t, uint8_t> _registers;
+
+     std::vector<uint8_t> _input;
+     Stats _stats = {};
+
+     std::mutex _mutex;
+     std::condition_variable _cv;
+     std::condition_variable _idle;
+     std::deque<Notification> _pending;
+     std::chrono::steady_clock::time_point _lastDue;
+     bool _stop = false;
+     std::thread _worker;
+
+     void run();
+     void processFrame(uint8_t command, const uint8_t *data, size_t length);
+     void schedule(const std::vector<uint8_t> &reply);
+     bool handleCommand(uint8_t command, const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+
+     void listPassiveTarget(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+     void autoPoll(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+     void dataExchange(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+     void communicateThru(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+     void iso15Command(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+     uint8_t iso15Inventory(const uint8_t *data, size_t length, std::vector<uint8_t> &reply);
+     void mifareCommand(const uint8_t *data, size_t length, std::vector<uint8_t> &response);
+
+     bool isUltralight() { return _hf14a.sak == 0x00; }
+     bool mifareAuth(uint8_t block, const uint8_t *key, bool keyA, const uint8_t *uid);
+     void readBlocks(uint8_t block, std::vector<uint8_t> &out);
+     bool writeBlock(uint8_t block, const uint8_t *data, size_t length);
+
+     static uint16_t crcA(const uint8_t *data, size_t length);
+     static uint16_t crc16Ccitt(const uint8_t *data, size_t length);
+ };
+
+ #endif // PN532_SIM_H
@@ -0,0 +1,61 @@
+/**
+ * @file pn532_trace.cpp
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Binary trace of the bytes exchanged with the reader
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+#include "pn532_trace.h"
+#include "pn532_log.h"
+
+size_t PN532_Trace::drain(std::function<void(const Record &record)> callback)
+{
+    size_t count = 0;
+    while (true)
+    {
+        Record *tx = _tx.front();
+        Record *rx = _rx.front();
+        if (!tx && !rx)
+        {
+            return count;
+        }
+        // Wrap-safe comparison of the microsecond timestamps
+        bool takeTx = tx && (!rx || (int32_t)(tx->timestampUs - rx->timestampUs) <= 0);
+        callback(takeTx ? *tx : *rx);
+        if (takeTx)
+        {
+            _tx.pop();
+        }
+        else
+        {
+            _rx.pop();
+        }
+        count++;
+    }
+}
+
+size_t PN532_Trace::print()
+{
+    uint32_t first = 0;
+    bool started = false;
+    size_t count = drain(
+        [&first, &started](const Record &record)
+        {
+            if (!started)
+            {
+                first = record.timestampUs;
+                started = true;
+            }
+            char prefix[32];
+            snprintf(
+                prefix, sizeof(prefix), "%9.3f ms %s %3u:", (record.timestampUs - first) / 1000.0,
+                record.direction == DirectionTx ? "<-" : "->", record.length);
+            pn532LogFrame(prefix, record.data, record.length < PN532_TRACE_BYTES ? record.length : PN532_TRACE_BYTES);
+        });
+    if (dropped() > 0)
+    {
+        Serial.printf("%u trace records dropped\n", (unsigned)dropped());
+    }
+    return count;
+}
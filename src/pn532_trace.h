@@ -0,0 +1,89 @@
+/**
+ * @file pn532_trace.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Binary trace of the bytes exchanged with the reader
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_TRACE_H
+ #define PN532_TRACE_H
+
+ #include "pn532_platform.h"
+ #include "pn532_ring.h"
+ #include <atomic>
+ #include <functional>
+
+ // Build with -DPN532_TRACE=1 to give every PN532 a trace; without it no RAM
+ // is spent and the hooks compile to nothing. Must be the same for the whole build.
+ #ifndef PN532_TRACE
+ #define PN532_TRACE 0
+ #endif
+ // Records kept per direction, a power of two
+ #ifndef PN532_TRACE_DEPTH
+ #define PN532_TRACE_DEPTH 32
+ #endif
+ // Bytes kept per record, longer frames are cut
+ #ifndef PN532_TRACE_BYTES
+ #define PN532_TRACE_BYTES 48
+ #endif
+
+ // Recording copies the bytes into a preallocated slot with a timestamp, no
+ // formatting, locking or allocation, so it is safe in the NimBLE callback.
+ // Each direction has its own SPSC ring: TX is written by the task sending
+ // commands, RX by the transport receive path. drain() merges both by time
+ // and is meant to run later, off the hot path. Records that find their ring
+ // full are counted in dropped().
+ class PN532_Trace {
+ public:
+     enum Direction {
+         DirectionTx, // frame written to the reader
+         DirectionRx, // chunk received from the reader, not aligned to frames
+     };
+
+     typedef struct {
+         uint32_t timestampUs;
+         uint16_t length; // bytes seen, data holds at most PN532_TRACE_BYTES of them
+         uint8_t direction;
+         uint8_t data[PN532_TRACE_BYTES];
+     } Record;
+
+     void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+     bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+     void recordTx(const uint8_t *data, size_t length) { record(_tx, DirectionTx, data, length); }
+     void recordRx(const uint8_t *data, size_t length) { record(_rx, DirectionRx, data, length); }
+
+     // Hands out and frees every record, oldest first. Returns how many.
+     size_t drain(std::function<void(const Record &record)> callback);
+     // Drains to Serial, one line per record
+     size_t print();
+     size_t dropped() const { return _tx.dropped() + _rx.dropped(); }
+
+ private:
+     typedef PN532_SpscRing<Record, PN532_TRACE_DEPTH> Ring;
+
+     Ring _tx;
+     Ring _rx;
+     std::atomic<bool> _enabled{true};
+
+     void record(Ring &ring, Direction direction, const uint8_t *data, size_t length)
+     {
+         if (!isEnabled())
+         {
+             return;
+         }
+         Record *slot = ring.acquire();
+         if (!slot)
+         {
+             return;
+         }
+         slot->timestampUs = micros();
+         slot->length = length;
+         slot->direction = direction;
+         memcpy(slot->data, data, length < PN532_TRACE_BYTES ? length : PN532_TRACE_BYTES);
+         ring.commit();
+     }
+ };
+
+ #endif // PN532_TRACE_H
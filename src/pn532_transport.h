@@ -0,0 +1,64 @@
+/**
+ * @file pn532_transport.h
+ * @author whywilson (https://github.com/whywilson)
+ * @brief Byte transport between the PN532 protocol engine and a reader
+ * @version 0.0.1
+ * @date 2026-10-15
+ */
+
+ #ifndef PN532_TRANSPORT_H
+ #define PN532_TRANSPORT_H
+
+ #include <atomic>
+ #include <functional>
+ #include <stddef.h>
+ #include <stdint.h>
+
+ class PN532_Transport {
+ public:
+     // Called with every chunk of bytes received from the reader, in order.
+     // Chunks are not aligned to frame boundaries.
+     typedef std::function<void(const uint8_t *data, size_t length)> ReceiveCallback;
+     // Called from the transport's own task when the link dropped unexpectedly
+     typedef std::function<void()> LinkLostCallback;
+
+     virtual ~PN532_Transport() {}
+
+     virtual bool isConnected() = 0;
+     virtual bool write(const uint8_t *data, size_t length) = 0;
+
+     void setReceiveCallback(ReceiveCallback callback) { _receiveCallback = callback; }
+     void setLinkLostCallback(LinkLostCallback callback) { _linkLostCallback = callback; }
+
+     // Set from the moment the link dropped until it is restored
+     bool linkLost() const { return _linkLost.load(); }
+     // Called by the protocol engine on the caller's task after the link
+     // dropped. Returns true once the transport is connected again; frames
+     // on the air at the time were lost with the link.
+     virtual bool restoreLink() { return false; }
+
+ protected:
+     void receive(const uint8_t *data, size_t length)
+     {
+         if (_receiveCallback)
+         {
+             _receiveCallback(data, length);
+         }
+     }
+     void linkDropped()
+     {
+         _linkLost = true;
+         if (_linkLostCallback)
+         {
+             _linkLostCallback();
+         }
+     }
+     void linkRestored() { _linkLost = false; }
+
+ private:
+     ReceiveCallback _receiveCallback;
+     LinkLostCallback _linkLostCallback;
+     std::atomic<bool> _linkLost{false};
+ };
+
+ #endif // PN532_TRANSPORT_H